@@ -17,8 +17,23 @@
  * 
  * Author:  Jan Michel (jan at mueschelsoft dot de)
  * License: GNU General Public License, version 3
- * Version: v0.96 April 2017
+ * Version: v0.97 October 2026
  * ****************************************************************************
+ * New features in v0.97
+ *   - optional shadow copy of display RAM (LCD_USE_SHADOW_RAM)
+ *   - added function lcd_blit_xy_P with raster operations and optional mask
+ *   - added function lcd_draw_image_packed_P for compressed images
+ *   - added function lcd_data_fill, used to clear areas
+ *   - bus to the display is selected in lcd-transport.h
+ *   - display stays selected during operations, bytes are prepared while
+ *     the previous one is sent (lcd_release)
+ *   - optional counters for diagnostics (LCD_USE_STATS)
+ *   - optional timing of rendering functions (LCD_USE_TIMING)
+ *   - drawing into canvases in RAM, lcd_canvas_blit (LCD_USE_CANVAS)
+ *   - portrait orientation using a canvas (LCD_ROTATION)
+ *   - added function lcd_transpose_8x8 (lcd-transpose.h)
+ *   - added functions lcd_draw_bitmap and lcd_draw_bitmap_stream for
+ *     row-major bitmaps (LCD_INCLUDE_BITMAP_FUNCTIONS)
  * New features in v0.96
  *   - added support for EA-DOGXL240 display
  * New features in v0.95
@@ -43,6 +58,67 @@
 
 #include "dogm-graphic.h"
 
+
+#if LCD_USE_STATS
+//=============================================================================
+//Counters for diagnostics, see lcd-stats.h
+//=============================================================================
+lcd_stats_t lcd_stats;
+
+/******************************************************************************
+ * Copies the counters
+ * s             - destination
+ */
+void lcd_stats_snapshot(lcd_stats_t *s) {
+  memcpy(s, &lcd_stats, sizeof(lcd_stats_t));
+  }
+
+/******************************************************************************
+ * Sets all counters to 0
+ */
+void lcd_stats_reset(void) {
+  memset(&lcd_stats, 0, sizeof(lcd_stats_t));
+  }
+#endif
+
+#if LCD_USE_TIMING
+//=============================================================================
+//Timing of rendering functions, see lcd-stats.h
+//=============================================================================
+lcd_timing_t lcd_timing[LCD_SPAN_COUNT];
+
+/******************************************************************************
+ * Adds a span to the timing table
+ * span          - group of functions, LCD_SPAN_*
+ * start         - LCD_TIMER() at the begin of the span
+ */
+void lcd_timing_record(uint8_t span, lcd_ticks_t start) {
+  lcd_ticks_t   t = (lcd_ticks_t)(LCD_TIMER() - start);
+  lcd_timing_t *s = &lcd_timing[span];
+  if (!s->count || t < s->min)
+    s->min = t;
+  if (t > s->max)
+    s->max = t;
+  s->sum += t;
+  s->count++;
+  }
+
+/******************************************************************************
+ * Copies the timing table
+ * t             - destination, LCD_SPAN_COUNT entries
+ */
+void lcd_timing_snapshot(lcd_timing_t *t) {
+  memcpy(t, lcd_timing, sizeof(lcd_timing));
+  }
+
+/******************************************************************************
+ * Clears the timing table
+ */
+void lcd_timing_reset(void) {
+  memset(lcd_timing, 0, sizeof(lcd_timing));
+  }
+#endif
+
 //=============================================================================
 //keeping track of current position in ram - necessary for big fonts & bitmaps
 //=============================================================================
@@ -50,6 +126,15 @@
 uint8_t lcd_current_page = 0;
 uint8_t lcd_current_column = 0;
 
+#if LCD_USE_SHADOW_RAM == 1
+uint8_t lcd_shadow[LCD_RAM_PAGES][LCD_WIDTH];
+#endif
+
+#if LCD_USE_CANVAS == 1
+lcd_canvas_t *lcd_target = 0;       //0: the display
+static uint8_t lcd_display_page;    //display cursor while drawing to a canvas
+static uint8_t lcd_display_column;
+#endif
 
 
 /******************************************************************************
@@ -58,6 +143,14 @@ uint8_t lcd_current_column = 0;
  */ 
 uint8_t lcd_inc_page(int8_t s) {
   uint8_t p = lcd_current_page;
+#if LCD_USE_CANVAS == 1
+  if (lcd_target) {           //canvas height is not always a power of two
+    int16_t q = (int16_t)p + s;
+    while (q < 0) q += lcd_target->pages;
+    lcd_current_page = q % lcd_target->pages;
+    return lcd_current_page;
+    }
+#endif
   p += s;
   p %= LCD_RAM_PAGES;    //all lcd have lcd_ram_pages which is power of two
   lcd_current_page = p;
@@ -72,11 +165,12 @@ uint8_t lcd_inc_column(int16_t s) {
   uint16_t c = lcd_current_column;
   c += s;
 #if LCD_WRAP_AROUND == 1
-  while (c >= LCD_WIDTH) {
+  uint8_t w = LCD_TARGET_WIDTH;
+  while (c >= w) {
     if (s > 0) lcd_inc_page(1);
     else       lcd_inc_page(-1);
-    if (s > 0) c -= LCD_WIDTH;
-    else       c += LCD_WIDTH;
+    if (s > 0) c -= w;
+    else       c += w;
     }
 #endif
   lcd_current_column = c;
@@ -90,9 +184,14 @@ uint8_t lcd_inc_column(int16_t s) {
  * columns       - column to move to
  */ 
 void lcd_moveto_xy(uint8_t page, uint8_t column) {
-  LCD_GOTO_ADDRESS(page,column);
   lcd_current_column = column; 
   lcd_current_page = page;
+#if LCD_USE_CANVAS == 1
+  if (lcd_target)
+    return;
+#endif
+  LCD_STAT_INC(address_sets);
+  LCD_GOTO_ADDRESS(page,column);
   }
 
 /******************************************************************************
@@ -105,38 +204,317 @@ void lcd_move_xy(int8_t pages, int16_t columns) {
   }
 
 
+#if LCD_USE_CANVAS == 1
+//=============================================================================
+//Canvas in RAM as target of all drawing functions
+//=============================================================================
+
+/******************************************************************************
+ * Prepares a canvas and clears it
+ * canvas        - the canvas
+ * buffer        - RAM for the canvas, pages * width bytes
+ * width         - width in pixels
+ * pages         - height in pages
+ */
+void lcd_canvas_init(lcd_canvas_t *canvas, uint8_t *buffer, uint8_t width, uint8_t pages) {
+  canvas->data  = buffer;
+  canvas->width = width;
+  canvas->pages = pages;
+  memset(buffer, 0, (uint16_t)width * pages);
+  }
+
+/******************************************************************************
+ * Selects where the following output is drawn. The cursor starts at the top
+ * left of a canvas, the cursor of the display is kept until it is selected
+ * again.
+ * canvas        - the canvas, 0 for the display
+ */
+void lcd_set_target(lcd_canvas_t *canvas) {
+  if (canvas == lcd_target)
+    return;
+  if (!lcd_target) {
+    lcd_release();
+    lcd_display_page   = lcd_current_page;
+    lcd_display_column = lcd_current_column;
+    }
+  lcd_target = canvas;
+  if (canvas) {
+    lcd_current_page   = 0;
+    lcd_current_column = 0;
+    }
+  else {
+    lcd_current_page   = lcd_display_page;
+    lcd_current_column = lcd_display_column;
+    }
+  }
+#endif
+
+
 //=============================================================================
 //Basic Byte Access to Display
+// The display stays selected between bytes. The bus is only waited for 
+// before the next byte is written or A0 changes, so the next byte is 
+// prepared while the current one is sent. lcd_release ends the transfer.
 //=============================================================================
 
+#define LCD_BUS_RELEASED  0
+#define LCD_BUS_COMMAND   1
+#define LCD_BUS_DATA      2
+static uint8_t lcd_bus_mode = LCD_BUS_RELEASED;
+
+/******************************************************************************
+ * Selects the display and sets A0 for the next bytes
+ * mode          - LCD_BUS_COMMAND or LCD_BUS_DATA
+ */
+static inline void lcd_bus_set_mode(uint8_t mode) {
+  if (lcd_bus_mode == mode)
+    return;
+  if (lcd_bus_mode == LCD_BUS_RELEASED) {
+    LCD_SELECT();
+    }
+  else {
+    lcd_bus_wait();
+    }
+  if (mode == LCD_BUS_DATA) {
+    LCD_DRAM();
+    }
+  else {
+    LCD_CMD();
+    }
+  lcd_bus_mode = mode;
+  }
+
+/******************************************************************************
+ * Waits until all bytes are sent and deselects the display. Called at the 
+ * end of all functions writing to the display, except lcd_data, 
+ * lcd_data_fill, lcd_command and the cursor movement functions. Call it 
+ * before using the bus for other devices after these.
+ */
+void lcd_release(void) {
+  if (lcd_bus_mode == LCD_BUS_RELEASED)
+    return;
+  LCD_UNSELECT();
+  lcd_bus_mode = LCD_BUS_RELEASED;
+  }
+
 /******************************************************************************
  * Writes one data byte
  * data          - the data byte
  */
 void lcd_data(uint8_t data) {
-  LCD_SELECT();
-  LCD_DRAM();
-  spi_write(data);
-  LCD_UNSELECT();
+#if LCD_USE_CANVAS == 1
+  if (lcd_target) {
+    if (lcd_current_column < lcd_target->width && lcd_current_page < lcd_target->pages)
+      lcd_target->data[lcd_current_page * lcd_target->width + lcd_current_column] = data;
+    lcd_inc_column(1);
+    return;
+    }
+#endif
+  lcd_bus_set_mode(LCD_BUS_DATA);
+  lcd_bus_write(data);
+#if LCD_USE_SHADOW_RAM == 1
+  if (lcd_current_column < LCD_WIDTH && lcd_current_page < LCD_RAM_PAGES)
+    lcd_shadow[lcd_current_page][lcd_current_column] = data;
+#endif
   lcd_inc_column(1);
   }
 
+/******************************************************************************
+ * Writes the same data byte several times
+ * data          - the data byte
+ * count         - number of bytes to write
+ */
+void lcd_data_fill(uint8_t data, uint8_t count) {
+#if LCD_WRAP_AROUND == 1
+  while(count--)
+    lcd_data(data);
+#else
+  #if LCD_USE_CANVAS == 1
+  if (lcd_target) {
+    uint8_t w = lcd_target->width;
+    if (lcd_current_column < w && lcd_current_page < lcd_target->pages)
+      memset(&lcd_target->data[lcd_current_page * w + lcd_current_column], data,
+             (count < w - lcd_current_column) ? count : w - lcd_current_column);
+    lcd_inc_column(count);
+    return;
+    }
+  #endif
+  #if LCD_USE_SHADOW_RAM == 1
+  if (lcd_current_column < LCD_WIDTH && lcd_current_page < LCD_RAM_PAGES)
+    memset(&lcd_shadow[lcd_current_page][lcd_current_column], data,
+           (count < LCD_WIDTH - lcd_current_column) ? count : LCD_WIDTH - lcd_current_column);
+  #endif
+  lcd_bus_set_mode(LCD_BUS_DATA);
+  for(uint8_t i = count; i; i--)
+    lcd_bus_write(data);
+  lcd_inc_column(count);
+#endif
+  }
+
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1 || LCD_ROTATION != 0 || LCD_INCLUDE_BITMAP_FUNCTIONS == 1
+/******************************************************************************
+ * Writes a row of data bytes from RAM
+ * data          - the data bytes
+ * count         - number of bytes to write
+ */
+static void lcd_data_block(const uint8_t *data, uint8_t count) {
+#if LCD_WRAP_AROUND == 1
+  while(count--)
+    lcd_data(*data++);
+#else
+  uint8_t w = LCD_TARGET_WIDTH;
+  uint8_t n = (lcd_current_column < w) ? w - lcd_current_column : 0;
+  if (n > count)
+    n = count;
+  #if LCD_USE_CANVAS == 1
+  if (lcd_target) {
+    if (n && lcd_current_page < lcd_target->pages)
+      memmove(&lcd_target->data[lcd_current_page * w + lcd_current_column], data, n);
+    lcd_inc_column(count);
+    return;
+    }
+  #endif
+  #if LCD_USE_SHADOW_RAM == 1
+  if (n && lcd_current_page < LCD_RAM_PAGES)
+    memcpy(&lcd_shadow[lcd_current_page][lcd_current_column], data, n);
+  #endif
+  lcd_bus_set_mode(LCD_BUS_DATA);
+  lcd_bus_write_burst(data, count);
+  lcd_inc_column(count);
+#endif
+  }
+#endif
+
 /******************************************************************************
  * Writes one command byte
  * cmd           - the command byte
  */
 void lcd_command(uint8_t cmd) {
-  LCD_SELECT();
-  LCD_CMD();
-  spi_write(cmd);
-  LCD_UNSELECT();
+  LCD_STAT_INC(commands);
+  lcd_bus_set_mode(LCD_BUS_COMMAND);
+  lcd_bus_write(cmd);
   }
   
 
+//=============================================================================
+//Rotation of pixel data
+//=============================================================================
+
+#if LCD_ROTATION == 90 || LCD_ROTATION == 270
+/******************************************************************************
+ * Sends a canvas in portrait orientation to the display (or the current
+ * target). The canvas is the whole view (LCD_VIEW_WIDTH x LCD_VIEW_PAGES) or
+ * a band of full height, so a frame can be drawn in parts. Each 8 x 8 block
+ * is transposed on the way, no other buffer is needed.
+ * canvas        - the view or band, width a multiple of 8
+ * x             - left column of the band in the view, a multiple of 8
+ */
+void lcd_canvas_flush_rotated(const lcd_canvas_t *canvas, uint8_t x) {
+  LCD_SPAN_BEGIN();
+  uint8_t src[8], dst[8];
+  uint8_t band, page, q, b, n;
+  uint8_t pages = (canvas->pages < LCD_VIEW_PAGES) ? canvas->pages : LCD_VIEW_PAGES;
+  for (band = 0; band < canvas->width / 8; band++) {
+    const uint8_t *col = canvas->data + band * 8;
+  #if LCD_ROTATION == 90
+    //view column x+c is display line LCD_HEIGHT-1-x-c, view line y is column y
+    page = (LCD_HEIGHT - x) / 8 - 1 - band;
+    lcd_moveto_xy(page, 0);
+    for (q = 0; q < pages; q++, col += canvas->width) {
+      for (b = 0; b < 8; b++)
+        src[b] = col[7 - b];
+      lcd_transpose_8x8(src, dst);
+      n = LCD_WIDTH - q * 8;
+      lcd_data_block(dst, (n < 8) ? n : 8);
+      }
+  #else
+    //view column x+c is display line x+c, view line y is column LCD_WIDTH-1-y
+    page = x / 8 + band;
+    n = (pages * 8 < LCD_WIDTH) ? LCD_WIDTH - pages * 8 : 0;
+    lcd_moveto_xy(page, n);
+    col += (pages - 1) * canvas->width;
+    for (q = pages; q; q--, col -= canvas->width) {
+      lcd_transpose_8x8(col, src);
+      for (b = 0; b < 8; b++)     //columns from right to left
+        dst[b] = src[7 - b];
+      n = LCD_WIDTH - (q - 1) * 8;
+      if (n < 8)
+        lcd_data_block(dst + 8 - n, n);
+      else
+        lcd_data_block(dst, 8);
+      }
+  #endif
+    }
+  lcd_release();
+  LCD_SPAN_END(LCD_SPAN_FLUSH);
+  }
+#endif
+
+
 //=============================================================================
 //Puts raw data from Flash to the Display
 //=============================================================================
 #if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+/******************************************************************************
+ * Reads a byte of an image from RAM or flash
+ */
+static inline uint8_t lcd_image_byte(const uint8_t *image, uint16_t index, uint8_t in_ram) {
+  return in_ram ? image[index] : pgm_read_byte((PGM_P)image + index);
+  }
+
+/******************************************************************************
+ * Common part of lcd_blit_xy_P and lcd_canvas_blit
+ * image, mask   - image and optional mask, columns bytes per page
+ * in_ram        - 1 if image and mask are in RAM, 0 for flash
+ * other parameters see lcd_blit_xy_P
+ */
+static void lcd_blit(const uint8_t *image, const uint8_t *mask, uint8_t in_ram, uint8_t x, uint8_t y, uint8_t pages, uint8_t columns, uint8_t rop) {
+  uint8_t i,j;
+  uint8_t src, cover, tmp;
+  uint8_t page   = y >> 3;
+  uint8_t offset = y & 0x7; //Optimized modulo 8
+  uint8_t height = pages;
+  uint8_t width  = LCD_TARGET_WIDTH;
+  uint8_t max    = (page < LCD_TARGET_PAGES) ? LCD_TARGET_PAGES - page : 0;
+  //If there is an offset, we must use an additional page
+  if(offset)
+    height++;
+  //If there is not enough vertical space -> cut image
+  if(height > max)
+    height = max;
+  //Aligned copy from RAM: whole rows at once
+  if(in_ram && !offset && !mask && rop == LCD_ROP_COPY) {
+    uint8_t visible = (x < width) ? width - x : 0;
+    if(visible > columns)
+      visible = columns;
+    for (j=0; j<height && visible; j++) {
+      lcd_moveto_xy(page+j, x);
+      lcd_data_block(image + j*columns, visible);
+      }
+    lcd_release();
+    return;
+    }
+  for (j=0; j<height; j++) {
+    lcd_moveto_xy(page+j, x);
+    for (i=0; i<columns && (lcd_get_position_column() < width); i++) {
+      src = 0; cover = 0;
+      if (j < pages) {
+        src   = lcd_image_byte(image, j*columns + i, in_ram) << offset;
+        tmp   = mask ? lcd_image_byte(mask, j*columns + i, in_ram) : 0xFF;
+        cover = tmp << offset;
+        }
+      if (j > 0 && offset) {
+        src   |= lcd_image_byte(image, (j-1)*columns + i, in_ram) >> (8-offset);
+        tmp    = mask ? lcd_image_byte(mask, (j-1)*columns + i, in_ram) : 0xFF;
+        cover |= tmp >> (8-offset);
+        }
+      tmp = lcd_target_get(page+j, lcd_get_position_column());
+      lcd_data(lcd_rop(tmp, src, cover, rop));
+      }
+    }
+  lcd_release();
+  }
+
 /******************************************************************************
  * This function draws a bitmap from the current position on the screen.
  * Parameters:
@@ -146,10 +524,11 @@ void lcd_command(uint8_t cmd) {
  * style         - Bit2: sets inverse mode
  */  
 void lcd_draw_image_P(PGM_VOID_P progmem_image, uint8_t pages, uint8_t columns, uint8_t style) {
+  LCD_SPAN_BEGIN();
 	uint8_t i,j = 0;
   uint8_t inv = (style & INVERT_BIT);
-	while(j<pages && (lcd_get_position_page() < LCD_RAM_PAGES)) {
-		for (i=0; i<columns && (lcd_get_position_column() < LCD_WIDTH); i++) {
+	while(j<pages && (lcd_get_position_page() < LCD_TARGET_PAGES)) {
+		for (i=0; i<columns && (lcd_get_position_column() < LCD_TARGET_WIDTH); i++) {
       uint8_t tmp = pgm_read_byte(progmem_image++);
 			if(!inv)
 				lcd_data(tmp);
@@ -159,12 +538,15 @@ void lcd_draw_image_P(PGM_VOID_P progmem_image, uint8_t pages, uint8_t columns,
     if(++j != pages && lcd_get_position_column() != 0)
       lcd_move_xy(1,-columns);
     }
+  lcd_release();
+  LCD_SPAN_END(LCD_SPAN_IMAGE);
   }
 
   
 /******************************************************************************
  * This function draws a bitmap at any xy-position on the screen. 
- * Be aware that some pixels are deleted due to memory organization!
+ * Pixels sharing a page with the image are kept if LCD_USE_SHADOW_RAM is
+ * set, otherwise they are cleared due to memory organization!
  * Parameters:
  * progmem_image - prog_uint8_t array of columns aka the bitmap image
  * x             - x start coordinate on the screen (in pixel)
@@ -174,31 +556,236 @@ void lcd_draw_image_P(PGM_VOID_P progmem_image, uint8_t pages, uint8_t columns,
  * style         - Bit2: sets inverse mode
  */
 void lcd_draw_image_xy_P(PGM_VOID_P progmem_image, uint8_t x, uint8_t y, uint8_t pages, uint8_t columns, uint8_t style) {
-	uint16_t i,j;
-  uint8_t data   = 0;
-  uint8_t inv    = style & INVERT_BIT;
-	uint8_t offset = y & 0x7; //Optimized modulo 8
-	//If there is an offset, we must use an additional page
-	if(offset)  
-    pages++;
-  //If there is not enough vertical space -> cut image
-  if(pages > LCD_RAM_PAGES - lcd_get_position_page())   
-    pages = LCD_RAM_PAGES - lcd_get_position_page();
-  //Goto starting point and draw
-	lcd_moveto_xy((y>>3), x);
-	for (j=0; j<pages; j++) {
-		for (i=0; i<columns && (lcd_get_position_column() < LCD_WIDTH); i++){
-      data = 0;
-      if (!offset || j+1 != pages)
-        data = pgm_read_byte(progmem_image+j*columns + i) << offset;
-			if(j > 0 && offset)
-				data |= pgm_read_byte(progmem_image+(j-1)*columns + i) >> (8-offset);
-			if(inv)	lcd_data(~data);
-      else 		lcd_data(data);
-		  }
-		if(j+1 != pages)
-			lcd_move_xy(1,-columns);
-	  }
+  lcd_blit_xy_P(progmem_image, 0, x, y, pages, columns, LCD_ROP_COPY | (style & INVERT_BIT));
+  }
+
+
+/******************************************************************************
+ * This function combines a bitmap with the display content at any 
+ * xy-position on the screen using a raster operation. The current content is
+ * taken from the shadow RAM, without LCD_USE_SHADOW_RAM it is assumed blank.
+ * Parameters:
+ * progmem_image - prog_uint8_t array of columns aka the bitmap image
+ * progmem_mask  - optional mask with the same layout as the image. Only pixels
+ *                 set in the mask are changed. Use 0 to change all pixels.
+ * x             - x start coordinate on the screen (in pixel)
+ * y             - y start coordinate on the screen (in pixel)
+ * pages         - height of image in pages
+ * columns       - width of image in pixels
+ * rop           - one of LCD_ROP_*, add INVERT_BIT to invert the image
+ */
+void lcd_blit_xy_P(PGM_VOID_P progmem_image, PGM_VOID_P progmem_mask, uint8_t x, uint8_t y, uint8_t pages, uint8_t columns, uint8_t rop) {
+  LCD_SPAN_BEGIN();
+  lcd_blit(progmem_image, progmem_mask, 0, x, y, pages, columns, rop);
+  LCD_SPAN_END(LCD_SPAN_IMAGE);
+  }
+
+#if LCD_USE_CANVAS == 1
+/******************************************************************************
+ * This function combines a canvas with the display or the current canvas at
+ * any xy-position using a raster operation. Aligned copies (y a multiple of
+ * 8, LCD_ROP_COPY) are written as blocks of bytes.
+ * Parameters:
+ * canvas        - the source, must not be the current target
+ * x             - x start coordinate on the target (in pixel)
+ * y             - y start coordinate on the target (in pixel)
+ * rop           - one of LCD_ROP_*, add INVERT_BIT to invert the canvas
+ */
+void lcd_canvas_blit(const lcd_canvas_t *canvas, uint8_t x, uint8_t y, uint8_t rop) {
+  LCD_SPAN_BEGIN();
+  lcd_blit(canvas->data, 0, 1, x, y, canvas->pages, canvas->width, rop);
+  LCD_SPAN_END(LCD_SPAN_FLUSH);
+  }
+#endif
+#endif
+
+
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 2
+/******************************************************************************
+ * This function draws a compressed bitmap from the current position on the
+ * screen. The data is decoded while it is sent to the display, runs of equal
+ * bytes are written using lcd_data_fill.
+ * Parameters:
+ * progmem_image - prog_uint8_t array, encoding byte followed by image data
+ * pages         - height of image in pages
+ * columns       - width of image in pixels (or columns)
+ * style         - Bit2: sets inverse mode
+ */
+void lcd_draw_image_packed_P(PGM_VOID_P progmem_image, uint8_t pages, uint8_t columns, uint8_t style) {
+  PGM_P   src     = (PGM_P)progmem_image;
+  uint8_t inv     = (style & INVERT_BIT)?0xFF:0;
+  uint8_t page    = lcd_get_position_page();
+  uint8_t start   = lcd_get_position_column();
+  uint8_t width   = LCD_TARGET_WIDTH;
+  uint8_t visible = (start < width)?width - start:0;
+  uint8_t col     = 0;  //current column in image
+  uint8_t n       = 0;  //bytes left in current token
+  uint8_t literal = 0;
+  uint8_t value   = 0;
+  uint8_t cnt, i;
+  
+  if (pgm_read_byte(src++) == LCD_IMAGE_RAW) {
+    lcd_draw_image_P(src, pages, columns, style);   //timed as image itself
+    return;
+    }
+  LCD_SPAN_BEGIN();
+  if (visible > columns)
+    visible = columns;
+  //If there is not enough vertical space -> cut image, decoding stops there
+  if (pages > LCD_TARGET_PAGES - page)
+    pages = (page < LCD_TARGET_PAGES) ? LCD_TARGET_PAGES - page : 0;
+  
+  while (pages) {
+    if (!n) {
+      n = pgm_read_byte(src++);
+      literal = !(n & 0x80);
+      if (literal) {
+        n++;
+        }
+      else {
+        n = n - 0x80 + 3;
+        value = pgm_read_byte(src++) ^ inv;
+        }
+      }
+    cnt = columns - col;
+    if (cnt > n)
+      cnt = n;
+    if (literal) {
+      for (i=0; i<cnt; i++) {
+        uint8_t tmp = pgm_read_byte(src++);
+        if (col+i < visible)
+          lcd_data(tmp ^ inv);
+        }
+      }
+    else if (col < visible) {
+      lcd_data_fill(value, (col+cnt <= visible)?cnt:visible-col);
+      }
+    col += cnt;
+    n   -= cnt;
+    if (col == columns) {
+      col = 0;
+      if (--pages)
+        lcd_moveto_xy(++page, start);
+      }
+    }
+  lcd_release();
+  LCD_SPAN_END(LCD_SPAN_IMAGE);
+  }
+#endif
+
+
+#if LCD_INCLUDE_BITMAP_FUNCTIONS == 1
+//=============================================================================
+//Row-major bitmaps from RAM or a stream
+// Each strip of 8 rows is converted to one page, 8 x 8 pixels at a time.
+//=============================================================================
+#define LCD_STRIP_BYTES  ((LCD_WIDTH + 7) / 8)   //per row, for streams
+
+/******************************************************************************
+ * Converts up to 8 rows of a bitmap to page-major bytes and writes them at 
+ * the current position. Lines of the page below the bitmap are kept if the
+ * content is known (canvas, shadow RAM), otherwise they are cleared.
+ * rows          - first byte of the first row
+ * stride        - distance of rows in bytes
+ * n             - number of rows, 1 to 8
+ * columns       - number of columns to write
+ * style         - see lcd_draw_bitmap
+ */
+static void lcd_bitmap_strip(const uint8_t *rows, uint8_t stride, uint8_t n, uint8_t columns, uint8_t style) {
+  uint8_t src[8], dst[8];
+  uint8_t cover = (n < 8) ? (1 << n) - 1 : 0xFF;
+  uint8_t inv   = (style & INVERT_BIT) ? cover : 0;
+  uint8_t page  = lcd_get_position_page();
+  uint8_t i, b, cnt;
+  for (i = 0; columns; i++, columns -= cnt) {
+    for (b = 0; b < 8; b++)
+      src[b] = (b < n) ? rows[b * stride + i] : 0;
+    lcd_transpose_8x8(src, dst);
+    if (!(style & LCD_BITMAP_LSB_FIRST)) {   //leftmost pixel is in bit 7
+      for (b = 0; b < 4; b++) {
+        uint8_t tmp = dst[b]; dst[b] = dst[7-b]; dst[7-b] = tmp;
+        }
+      }
+    cnt = (columns < 8) ? columns : 8;
+    for (b = 0; b < cnt; b++) {
+      dst[b] ^= inv;
+      if (n < 8)
+        dst[b] |= lcd_target_get(page, lcd_get_position_column() + b) & ~cover;
+      }
+    lcd_data_block(dst, cnt);
+    }
+  }
+
+/******************************************************************************
+ * This function draws a row-major bitmap from RAM at the current position.
+ * Parameters:
+ * bitmap        - rows of (width+7)/8 bytes, see LCD_BITMAP_*
+ * width         - width in pixels
+ * height        - height in pixels
+ * style         - Bit2: sets inverse mode, add LCD_BITMAP_LSB_FIRST for XBM
+ */
+void lcd_draw_bitmap(const uint8_t *bitmap, uint8_t width, uint8_t height, uint8_t style) {
+  LCD_SPAN_BEGIN();
+  uint8_t  stride  = (width + 7) / 8;
+  uint8_t  page    = lcd_get_position_page();
+  uint8_t  start   = lcd_get_position_column();
+  uint8_t  columns = (start < LCD_TARGET_WIDTH) ? LCD_TARGET_WIDTH - start : 0;
+  uint16_t y;
+  if (columns > width)
+    columns = width;
+  for (y = 0; y < height && page < LCD_TARGET_PAGES && columns; y += 8, page++) {
+    lcd_moveto_xy(page, start);
+    lcd_bitmap_strip(bitmap + y * stride, stride, (height - y < 8) ? height - y : 8, columns, style);
+    }
+  lcd_release();
+  LCD_SPAN_END(LCD_SPAN_IMAGE);
+  }
+
+/******************************************************************************
+ * This function draws a row-major bitmap read by a function, e.g. from a 
+ * serial port or a file, at the current position. Only one strip of 8 rows
+ * is stored. All rows are read, also those not visible.
+ * Parameters:
+ * read          - function returning the next bytes of the bitmap
+ * width         - width in pixels, up to LCD_WIDTH columns are drawn
+ * height        - height in pixels
+ * style         - Bit2: sets inverse mode, add LCD_BITMAP_LSB_FIRST for XBM
+ * Returns 0 if read failed, 1 otherwise
+ */
+uint8_t lcd_draw_bitmap_stream(lcd_bitmap_read_t read, uint8_t width, uint8_t height, uint8_t style) {
+  LCD_SPAN_BEGIN();
+  uint8_t  strip[8 * LCD_STRIP_BYTES];
+  uint8_t  skip[8];
+  uint8_t  stride  = (width + 7) / 8;
+  uint8_t  page    = lcd_get_position_page();
+  uint8_t  start   = lcd_get_position_column();
+  uint8_t  columns = (start < LCD_TARGET_WIDTH) ? LCD_TARGET_WIDTH - start : 0;
+  uint8_t  keep, n, r, cnt, rest;
+  uint8_t  ok = 1;
+  uint16_t y;
+  if (columns > width)
+    columns = width;
+  if (columns > LCD_WIDTH)
+    columns = LCD_WIDTH;
+  keep = (columns + 7) / 8;       //bytes per row stored
+  for (y = 0; y < height && ok; y += 8, page++) {
+    n = (height - y < 8) ? height - y : 8;
+    for (r = 0; r < n && ok; r++) {
+      if (keep)
+        ok = read(strip + r * keep, keep);
+      for (rest = stride - keep; rest && ok; rest -= cnt) {
+        cnt = (rest < 8) ? rest : 8;
+        ok = read(skip, cnt);
+        }
+      }
+    if (ok && columns && page < LCD_TARGET_PAGES) {
+      lcd_moveto_xy(page, start);
+      lcd_bitmap_strip(strip, keep, n, columns, style);
+      }
+    }
+  lcd_release();
+  LCD_SPAN_END(LCD_SPAN_IMAGE);
+  return ok;
   }
 #endif
 
@@ -211,21 +798,22 @@ void lcd_draw_image_xy_P(PGM_VOID_P progmem_image, uint8_t x, uint8_t y, uint8_t
  * Cursor is moved to start of area after clear
  */
 void lcd_clear_area(uint8_t pages, uint8_t columns, uint8_t style) {
-  uint8_t i,j,max;
+  LCD_SPAN_BEGIN();
+  uint8_t j,max;
   uint8_t inv = (style & INVERT_BIT)?0xFF:0;
   
-  if(pages > (max = LCD_RAM_PAGES - lcd_get_position_page()))   
+  if(pages > (max = LCD_TARGET_PAGES - lcd_get_position_page()))   
     pages = max;
-  if(columns > (max = LCD_WIDTH - lcd_get_position_column()))   
+  if(columns > (max = LCD_TARGET_WIDTH - lcd_get_position_column()))   
     columns = max;
   
   for(j=0; j<pages; j++) {
-    for(i=0; i<columns; i++) {
-      lcd_data(inv);
-      }
+    lcd_data_fill(inv, columns);
     lcd_move_xy(1,-columns);
     }
   lcd_move_xy(-pages,0);
+  lcd_release();
+  LCD_SPAN_END(LCD_SPAN_CLEAR);
   }
 
 /******************************************************************************
@@ -250,6 +838,7 @@ void lcd_clear_area_xy(uint8_t pages, uint8_t columns, uint8_t style, uint8_t pa
   void lcd_set_contrast(uint8_t value) {
       uint8_t x = (uint8_t)((uint16_t)value*255/100);	// calculate 0-255 value from percent
       LCD_SET_POTI(x);
+      lcd_release();
   } 
 #endif
 
@@ -261,7 +850,7 @@ void lcd_clear_area_xy(uint8_t pages, uint8_t columns, uint8_t style, uint8_t pa
   */
 void lcd_init() {
   LCD_SET_PIN_DIRECTIONS();  //set outputs
-  LCD_INIT_SPI();            //Initialize SPI Interface  
+  LCD_BUS_INIT();            //Initialize SPI Interface  
   LCD_RESET();               //Apply Reset to the Display Controller
   //Load settings
   #if DISPLAY_TYPE == 240
@@ -344,5 +933,6 @@ void lcd_init() {
   lcd_clear_area_xy(LCD_RAM_PAGES,LCD_WIDTH,NORMAL,0,0); //clear display content
 
   LCD_SWITCH_ON();                    //Switch display on
+  lcd_release();
   return;
   }
@@ -12,10 +12,23 @@
  * BEGIN CONFIG BLOCK
  *****************************************************************************/
 //Select the display type: DOGS102: 102, DOGM128/DOGL128: 128, DOGM132: 132, DOGXL160: 160, DOGXL240: 240
-#define DISPLAY_TYPE  240
+//(the host test of dogm-graphic.hpp sets it and the orientation on the command line)
+#ifndef DISPLAY_TYPE
+  #define DISPLAY_TYPE  240
+#endif
 
 //Display Orientation: Normal (0) or upside-down (1)?
-#define ORIENTATION_UPSIDEDOWN 0
+#ifndef ORIENTATION_UPSIDEDOWN
+  #define ORIENTATION_UPSIDEDOWN 0
+#endif
+
+//Portrait orientation: 0 (none), 90 or 270 degrees clockwise. Output is drawn
+//into a canvas of LCD_VIEW_WIDTH x LCD_VIEW_PAGES (or a band of it) and sent
+//with lcd_canvas_flush_rotated. Needs LCD_USE_CANVAS, not for DOGXL160.
+//(host tests set it on the command line)
+#ifndef LCD_ROTATION
+  #define LCD_ROTATION  0
+#endif
 
 //Should chip select (CS) be used?
 #define LCD_USE_CHIPSELECT  1
@@ -55,6 +68,10 @@ extern void init_spi_lcd(void);
 //Define a function that waits until SPI interface is idle
 #define spi_wait_for_idle() while(! (SPIF_STATUS & _BV(SPI_IF_bp)))
 
+//Define how to test if the SPI interface is idle (optional, used to count
+//the loops waiting for the bus with LCD_USE_STATS)
+#define spi_idle()   (SPIF_STATUS & _BV(SPI_IF_bp))
+
 //Define how to write to SPI data register
 #define spi_write(i) SPIF_DATA = i
 
@@ -63,7 +80,43 @@ extern void init_spi_lcd(void);
 #define LCD_WRAP_AROUND  0
 
 //Include graphic functions, i.e. lcd_draw_image_P, lcd_draw_image_xy_P, lcd_clear_area ? 
-#define LCD_INCLUDE_GRAPHIC_FUNCTIONS  1
+//Set to 2 to include lcd_draw_image_packed_P for compressed images as well
+//(host tests set it on the command line)
+#ifndef LCD_INCLUDE_GRAPHIC_FUNCTIONS
+  #define LCD_INCLUDE_GRAPHIC_FUNCTIONS  1
+#endif
+
+//Include lcd_draw_bitmap and lcd_draw_bitmap_stream for row-major bitmaps 
+//(PBM, XBM) loaded at runtime? (host tests set it on the command line)
+#ifndef LCD_INCLUDE_BITMAP_FUNCTIONS
+  #define LCD_INCLUDE_BITMAP_FUNCTIONS  0
+#endif
+
+//Keep a copy of the display content in RAM (LCD_RAM_PAGES * LCD_WIDTH bytes)?
+//Needed for raster operations (OR, AND-NOT, XOR) and to keep pixels next to
+//images drawn at unaligned y positions. Without it, the display is assumed blank.
+#ifndef LCD_USE_SHADOW_RAM
+  #define LCD_USE_SHADOW_RAM  0
+#endif
+
+//Allow drawing into canvases in RAM (lcd_set_target, lcd_canvas_blit)?
+//lcd_canvas_blit needs LCD_INCLUDE_GRAPHIC_FUNCTIONS
+//(host tests set it on the command line)
+#ifndef LCD_USE_CANVAS
+  #define LCD_USE_CANVAS  0
+#endif
+
+//Count bytes, commands, glyph lookups etc. in lcd_stats for diagnostics?
+//See lcd-stats.h. Without it, no code or memory is used.
+#define LCD_USE_STATS  0
+
+//Measure the time of text output, images, clearing and flushing in 
+//lcd_timing (see lcd-stats.h)? LCD_TIMER() has to read a free running
+//counter of type LCD_TIMER_TYPE. Longer spans than one period of the
+//counter are not measured correctly.
+#define LCD_USE_TIMING  0
+#define LCD_TIMER()     TCC1.CNT
+#define LCD_TIMER_TYPE  uint16_t
 
 /*Example SPI setup (Atmega162)
  *init spi: msb first, update on falling edge , read on rising edge, 9 MHz
@@ -90,7 +143,10 @@ void lcd_init(void);
 
 //write data word or command to the LCD
 void lcd_data     (uint8_t data);
+void lcd_data_fill(uint8_t data, uint8_t count);
 void lcd_command  (uint8_t cmd);
+//finish writing and deselect the display, see dogm-graphic.c
+void lcd_release  (void);
 
 
 //Function to read the current position
@@ -103,6 +159,18 @@ static inline uint8_t lcd_get_position_column(void) {return lcd_current_column;}
 #if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
   void lcd_draw_image_P(PGM_VOID_P progmem_image, uint8_t pages, uint8_t columns, uint8_t style);
   void lcd_draw_image_xy_P(PGM_VOID_P progmem_image, uint8_t x, uint8_t y, uint8_t pages, uint8_t columns, uint8_t style);
+  void lcd_blit_xy_P(PGM_VOID_P progmem_image, PGM_VOID_P progmem_mask, uint8_t x, uint8_t y, uint8_t pages, uint8_t columns, uint8_t rop);
+#endif
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 2
+  void lcd_draw_image_packed_P(PGM_VOID_P progmem_image, uint8_t pages, uint8_t columns, uint8_t style);
+#endif
+
+//User functions to write row-major bitmaps from RAM or e.g. a serial port.
+//The read function stores the next count bytes in buffer, returns 0 on error.
+#if LCD_INCLUDE_BITMAP_FUNCTIONS == 1
+  typedef uint8_t (*lcd_bitmap_read_t)(uint8_t *buffer, uint8_t count);
+  void    lcd_draw_bitmap(const uint8_t *bitmap, uint8_t width, uint8_t height, uint8_t style);
+  uint8_t lcd_draw_bitmap_stream(lcd_bitmap_read_t read, uint8_t width, uint8_t height, uint8_t style);
 #endif
 
 void lcd_clear_area(uint8_t pages, uint8_t columns, uint8_t style);
@@ -167,6 +235,113 @@ void lcd_move_xy    (int8_t pages, int16_t columns);
   #define SHIFT_ADDR_TOPVIEW 30  //column offset for bottom view orientation
 #endif
 
+//Bit positions for style settings
+#define NORMAL      0
+#define INVERT      4
+#define INVERT_BIT  4
+
+
+/*****************************************************************************
+ * Raster operations for lcd_blit_xy_P
+ * The source can additionally be inverted by adding INVERT_BIT
+ *****************************************************************************/
+#define LCD_ROP_COPY    0   //replace destination
+#define LCD_ROP_OR      1   //set pixels
+#define LCD_ROP_ANDNOT  2   //clear pixels
+#define LCD_ROP_XOR     3   //toggle pixels, e.g. for cursors
+#define LCD_ROP_MASK    3
+
+//Combines destination and source byte. Only bits set in cover are changed.
+static inline uint8_t lcd_rop(uint8_t dst, uint8_t src, uint8_t cover, uint8_t rop) {
+  uint8_t res;
+  if (rop & INVERT_BIT) src = ~src;
+  switch (rop & LCD_ROP_MASK) {
+    case LCD_ROP_OR:     res = dst |  src; break;
+    case LCD_ROP_ANDNOT: res = dst & ~src; break;
+    case LCD_ROP_XOR:    res = dst ^  src; break;
+    default:             res = src;        break;
+    }
+  return (dst & ~cover) | (res & cover);
+  }
+
+//Copy of the display content, written by lcd_data()
+#if LCD_USE_SHADOW_RAM == 1
+  extern uint8_t lcd_shadow[LCD_RAM_PAGES][LCD_WIDTH];
+  static inline uint8_t lcd_shadow_get(uint8_t page, uint8_t column) {return lcd_shadow[page][column];}
+#else
+  static inline uint8_t lcd_shadow_get(uint8_t page, uint8_t column) {return 0;}
+#endif
+
+//Canvas: a RAM buffer in the layout of the display memory (page-major, one
+//byte is 8 vertical pixels). After lcd_set_target(canvas), lcd_data, the
+//cursor functions, images, clearing and text write to the canvas instead
+//of the display. lcd_set_target(0) selects the display again.
+#if LCD_USE_CANVAS == 1
+  typedef struct {
+    uint8_t *data;      //pages * width bytes
+    uint8_t  width;     //in pixels
+    uint8_t  pages;     //height in pages of 8 pixels
+    } lcd_canvas_t;
+
+  extern lcd_canvas_t *lcd_target;
+  void lcd_canvas_init(lcd_canvas_t *canvas, uint8_t *buffer, uint8_t width, uint8_t pages);
+  void lcd_set_target(lcd_canvas_t *canvas);
+  #if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+    void lcd_canvas_blit(const lcd_canvas_t *canvas, uint8_t x, uint8_t y, uint8_t rop);
+  #endif
+  #define LCD_TARGET_WIDTH   (lcd_target ? lcd_target->width : LCD_WIDTH)
+  #define LCD_TARGET_PAGES   (lcd_target ? lcd_target->pages : LCD_RAM_PAGES)
+#else
+  #define LCD_TARGET_WIDTH   LCD_WIDTH
+  #define LCD_TARGET_PAGES   LCD_RAM_PAGES
+#endif
+//Width of the display or canvas written to
+static inline uint8_t lcd_get_width(void) {return LCD_TARGET_WIDTH;}
+
+//Size of the view, i.e. the canvas for portrait orientation
+#if LCD_ROTATION == 90 || LCD_ROTATION == 270
+  #if LCD_USE_CANVAS != 1 || defined(LCD_DOUBLE_PIXEL)
+    #error "LCD_ROTATION needs LCD_USE_CANVAS and single pixel bytes"
+  #endif
+  #define LCD_VIEW_WIDTH   LCD_HEIGHT
+  #define LCD_VIEW_HEIGHT  LCD_WIDTH
+  #define LCD_VIEW_PAGES   ((LCD_WIDTH + 7) / 8)
+  void lcd_canvas_flush_rotated(const lcd_canvas_t *canvas, uint8_t x);
+#else
+  #define LCD_VIEW_WIDTH   LCD_WIDTH
+  #define LCD_VIEW_HEIGHT  LCD_HEIGHT
+  #define LCD_VIEW_PAGES   LCD_RAM_PAGES
+#endif
+
+//Current content of the display or canvas written to
+static inline uint8_t lcd_target_get(uint8_t page, uint8_t column) {
+#if LCD_USE_CANVAS == 1
+  if (lcd_target)
+    return lcd_target->data[page * lcd_target->width + column];
+#endif
+  return lcd_shadow_get(page, column);
+  }
+
+/*****************************************************************************
+ * Compressed image format for lcd_draw_image_packed_P
+ * The first byte selects the encoding, followed by the page-major data.
+ * Packed data consists of tokens:
+ *   0x00 - 0x7F: the next (token+1) bytes are copied
+ *   0x80 - 0xFF: the next byte is repeated (token-0x80+3) times
+ * Images can be converted with tools/lcd-image-convert.py
+ *****************************************************************************/
+#define LCD_IMAGE_RAW         0
+#define LCD_IMAGE_PACKBITS    1
+
+/*****************************************************************************
+ * Row-major bitmaps for lcd_draw_bitmap, one bit per pixel, set bits are
+ * black. Each row starts with a new byte. Add to the style:
+ *   LCD_BITMAP_MSB_FIRST: leftmost pixel in bit 7, e.g. raster of PBM (P4)
+ *   LCD_BITMAP_LSB_FIRST: leftmost pixel in bit 0, e.g. data of XBM
+ *****************************************************************************/
+#define LCD_BITMAP_MSB_FIRST  0
+#define LCD_BITMAP_LSB_FIRST  0x80
+
 #if ORIENTATION_UPSIDEDOWN == 0
   #define SHIFT_ADDR   SHIFT_ADDR_NORMAL
 #endif
@@ -463,6 +638,7 @@ void lcd_move_xy    (int8_t pages, int16_t columns);
 #define LCD_DRAM()            PORT_A0 |= _BV(PIN_A0)
 #define LCD_CMD()             PORT_A0 &= ~_BV(PIN_A0)
 #define LCD_SET_OUTPUT_A0()   DDR_A0  |= _BV(PIN_A0)
+#define LCD_BUS_DC()          (PORT_A0 & _BV(PIN_A0))
 
 //Control reset input of LCD
 #define LCD_RESET_OFF()       PORT_RST |= _BV(PIN_RST)
@@ -488,12 +664,12 @@ void lcd_move_xy    (int8_t pages, int16_t columns);
 //Control pin for chip select
 #if LCD_USE_CHIPSELECT == 1
   #define LCD_SET_OUTPUT_CS()  DDR_CS  |= _BV(PIN_CS)
-  #define LCD_SELECT()         PORT_CS &= ~_BV(PIN_CS)
-  #define LCD_UNSELECT()       spi_wait_for_idle(); PORT_CS |= _BV(PIN_CS)
+  #define LCD_SELECT()         PORT_CS &= ~_BV(PIN_CS); LCD_BUS_SELECTED(1); LCD_STAT_INC(selects)
+  #define LCD_UNSELECT()       lcd_bus_wait(); PORT_CS |= _BV(PIN_CS); LCD_BUS_SELECTED(0)
 #else
   #define LCD_SET_OUTPUT_CS()  
-  #define LCD_SELECT()         spi_wait_for_idle();
-  #define LCD_UNSELECT()   
+  #define LCD_SELECT()         lcd_bus_wait();
+  #define LCD_UNSELECT()       lcd_bus_wait();
 #endif
 
 //combined direction selection for all pins
@@ -502,11 +678,10 @@ void lcd_move_xy    (int8_t pages, int16_t columns);
                                    LCD_SET_OUTPUT_LED(); \
                                    LCD_SET_OUTPUT_CS()
 
-
-//Bit positions for style settings
-#define NORMAL      0
-#define INVERT      4
-#define INVERT_BIT  4
+//Bus to the display, the SPI routines above are used by LCD_TRANSPORT_SPI
+#include "lcd-stats.h"
+#include "lcd-transport.h"
+#include "lcd-transpose.h"
 
 
 #endif
@@ -0,0 +1,367 @@
+#ifndef DOGMGRAPHIC_HPP_INCLUDED
+#define DOGMGRAPHIC_HPP_INCLUDED
+
+/******************************************************************************
+ * Display Library, C++ version
+ * for EA-DOGS102, DOGM128, DOGL128, DOGM132, DOGXL160 and DOGXL240
+ *
+ * Header only. The display type, pins and SPI interface are template
+ * parameters instead of the defines in dogm-graphic.h, so displays of
+ * different types can be used in one program:
+ *
+ *   DOGM_PIN(A0,  PORTB, DDRB, 0);
+ *   DOGM_PIN(RST, PORTB, DDRB, 1);
+ *   DOGM_PIN(CS,  PORTB, DDRB, 2);
+ *   DOGM_PIN(CS2, PORTB, DDRB, 3);
+ *   DOGM_SPI(Spi, init_spi_lcd(), while(!(SPSR & _BV(SPIF))), SPDR);
+ *
+ *   typedef dogm::Display<dogm::DOGXL240, dogm::Pins<A0,RST,CS>,  Spi> Big;
+ *   typedef dogm::Display<dogm::DOGS102,  dogm::Pins<A0,RST,CS2>, Spi, true> Small;
+ *   Big::init();  Small::init();
+ *   Big::moveto_xy(2, 10);
+ *   Big::draw_image_P(logo, 2, 32, dogm::normal);
+ *
+ * All functions are static and inline, commands are encoded at compile time
+ * for the display type. Each display type has its own cursor.
+ * Functions work like those of dogm-graphic.c (without wrap around, shadow
+ * RAM, raster operations and packed images). Text is written by font.c,
+ * which is bound to the display configured in dogm-graphic.h.
+ *
+ * Author:  Jan Michel (jan at mueschelsoft dot de)
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <avr/io.h>
+#include <inttypes.h>
+#include <util/delay.h>
+#include <avr/pgmspace.h>
+
+/*****************************************************************************
+ * Pins and SPI interface
+ *****************************************************************************/
+//Defines a pin type, e.g. DOGM_PIN(A0, PORTB, DDRB, 0)
+#define DOGM_PIN(name, port, ddr, bit) \
+  struct name { \
+    static void    output() {ddr  |=  _BV(bit);} \
+    static void    high()   {port |=  _BV(bit);} \
+    static void    low()    {port &= ~_BV(bit);} \
+    static uint8_t get()    {return port & _BV(bit);} \
+    }
+
+//Defines a SPI type: a function initializing the interface, a loop waiting
+//until it is idle and the data register, see dogm-graphic.h
+#define DOGM_SPI(name, init_call, wait_loop, data_reg) \
+  struct name { \
+    static void init()            {init_call;} \
+    static void wait()            {wait_loop;} \
+    static void write(uint8_t b)  {data_reg = b;} \
+    }
+
+namespace dogm {
+
+//Pin not connected, e.g. chip select tied low
+struct NoPin {
+  static void    output() {}
+  static void    high()   {}
+  static void    low()    {}
+  static uint8_t get()    {return 0;}
+  };
+
+//A0 (CD), reset and chip select
+template<class A0, class RST, class CS = NoPin>
+struct Pins {
+  typedef A0  a0;
+  typedef RST rst;
+  typedef CS  cs;
+  };
+
+//Style bits, same values as NORMAL and INVERT of dogm-graphic.h
+const uint8_t normal = 0;
+const uint8_t invert = 4;
+
+
+/*****************************************************************************
+ * Display types: size, address commands and initialization
+ * D is the display, it provides command()
+ *****************************************************************************/
+//Common to the ST7565R (DOGM128/132, DOGL128) and UC1701 (DOGS102)
+template<class D, bool UpsideDown>
+static inline void st7565_start() {
+  D::command(0x40);                       //first line 0
+  D::command(UpsideDown ? 0xA0 : 0xA1);   //top / bottom view
+  D::command(UpsideDown ? 0xC8 : 0xC0);   //scan direction
+  D::command(0xA4);                       //normal pixel mode
+  D::command(0xA6);                       //positive display
+  }
+
+template<class D>
+static inline void st7565_power(uint8_t bias, uint8_t voltage, uint8_t volume) {
+  D::command(0xA2 | bias);                //bias 1/9 (0) or 1/7 (1)
+  D::command(0x28 | 7);                   //power control: all features on
+  D::command(0x20 | voltage);             //voltage regulator R/R
+  D::command(0x81);                       //volume mode set
+  D::command(volume & 0x3F);
+  }
+
+struct DOGM128 {
+  static const uint8_t width = 128, height = 64, pages = 8;
+  template<class D, bool UpsideDown>
+  static void goto_address(uint8_t page, uint8_t col) {
+    col += UpsideDown ? 4 : 0;
+    D::command(0xB0 | (page & 0x1F));
+    D::command(0x10 | ((col >> 4) & 0x0F));
+    D::command(col & 0x0F);
+    }
+  template<class D, bool UpsideDown>
+  static void init() {
+    st7565_start<D,UpsideDown>();
+    st7565_power<D>(1, 7, 0x06);
+    D::command(0xAC); D::command(0x00);   //indicator off
+    }
+  template<class D>
+  static void switch_on() {D::command(0xAF);}
+  };
+
+typedef DOGM128 DOGL128;
+
+struct DOGM132 {
+  static const uint8_t width = 132, height = 32, pages = 4;
+  template<class D, bool UpsideDown>
+  static void goto_address(uint8_t page, uint8_t col) {
+    D::command(0xB0 | (page & 0x1F));
+    D::command(0x10 | ((col >> 4) & 0x0F));
+    D::command(col & 0x0F);
+    }
+  template<class D, bool UpsideDown>
+  static void init() {
+    st7565_start<D,UpsideDown>();
+    st7565_power<D>(0, 3, 0x1F);
+    D::command(0xAC); D::command(0x00);   //indicator off
+    }
+  template<class D>
+  static void switch_on() {D::command(0xAF);}
+  };
+
+struct DOGS102 {
+  static const uint8_t width = 102, height = 64, pages = 8;
+  template<class D, bool UpsideDown>
+  static void goto_address(uint8_t page, uint8_t col) {
+    col += UpsideDown ? 30 : 0;
+    D::command(0xB0 | (page & 0x0F));
+    D::command(col & 0x0F);
+    D::command(0x10 | ((col >> 4) & 0x0F));
+    }
+  template<class D, bool UpsideDown>
+  static void init() {
+    st7565_start<D,UpsideDown>();
+    st7565_power<D>(0, 7, 0x09);
+    D::command(0xFA); D::command(0x90);   //advanced program control: temp. comp. high
+    }
+  template<class D>
+  static void switch_on() {D::command(0xAF);}
+  };
+
+struct DOGXL160 {
+  static const uint8_t width = 160, height = 104, pages = 26;
+  template<class D, bool UpsideDown>
+  static void goto_address(uint8_t page, uint8_t col) {
+    D::command(0x60 | (page & 0x1F));
+    D::command(0x10 | ((col >> 4) & 0x0F));
+    D::command(col & 0x0F);
+    }
+  template<class D, bool UpsideDown>
+  static void init() {
+    D::command(0xF1); D::command(103);    //last COM electrode
+    D::command(UpsideDown ? 0xC6 : 0xC0); //top / bottom view
+    D::command(0x40); D::command(0x50);   //scrolling to 0
+    D::command(0x28 | 3);                 //panel loading 28-38nF
+    D::command(0xE8 | 3);                 //bias ratio
+    D::command(0x81); D::command(0x5F);   //Vbias potentiometer for contrast
+    D::command(0x88 | 1);                 //auto-increment
+    }
+  template<class D>
+  static void switch_on() {D::command(0xAF);}
+  };
+
+struct DOGXL240 {
+  static const uint8_t width = 240, height = 128, pages = 16;
+  template<class D, bool UpsideDown>
+  static void goto_address(uint8_t page, uint8_t col) {
+    D::command(0x60 | (page & 0x0F));
+    D::command(0x70 | ((page >> 4) & 0x0F));
+    D::command(0x10 | ((col >> 4) & 0x0F));
+    D::command(col & 0x0F);
+    }
+  template<class D, bool UpsideDown>
+  static void init() {
+    D::command(0xF1); D::command(127);    //last COM electrode
+    D::command(0xF2); D::command(0);      //partial display start and end
+    D::command(0xF3); D::command(127);
+    D::command(0x81); D::command(0x8F);   //contrast to mid range
+    D::command(0xC0); D::command(2);      //mapping control "bottom view"
+    D::command(0xA0 | (11 & 3));          //line rate
+    D::command(0x24 | 1);                 //temperature compensation -0.10%
+    D::command(0xA9);                     //display enable
+    D::command(0xD1);                     //display pattern
+    D::command(0x88 | 1);                 //auto-increment
+    }
+  template<class D>
+  static void switch_on() {D::command(0xA9);}
+  //contrast in percent (0 to 100)
+  template<class D>
+  static void set_contrast(uint8_t value) {
+    D::command(0x81);
+    D::command((uint8_t)((uint16_t)value*255/100));
+    }
+  };
+
+
+/*****************************************************************************
+ * The display
+ * Panel         - display type, e.g. DOGXL240
+ * P             - Pins<A0, RST, CS>
+ * Spi           - SPI interface, see DOGM_SPI
+ * UpsideDown    - orientation (top view)
+ *****************************************************************************/
+template<class Panel, class P, class Spi, bool UpsideDown = false>
+class Display {
+  public:
+    static const uint8_t width  = Panel::width;
+    static const uint8_t height = Panel::height;
+    static const uint8_t pages  = Panel::pages;
+
+    //Initializes the display and clears it
+    static void init() {
+      P::a0::output();
+      P::rst::output();
+      P::cs::high();
+      P::cs::output();
+      Spi::init();
+      P::rst::low();
+      _delay_ms(1);
+      P::rst::high();
+      _delay_ms(10);
+      Panel::template init<Display,UpsideDown>();
+      clear_area_xy(pages, width, normal, 0, 0);
+      Panel::template switch_on<Display>();
+      release();
+      }
+
+    //Writes one command byte
+    static void command(uint8_t cmd) {
+      set_mode(mode_command);
+      Spi::wait();
+      Spi::write(cmd);
+      }
+
+    //Writes one data byte
+    static void data(uint8_t d) {
+      set_mode(mode_data);
+      Spi::wait();
+      Spi::write(d);
+      column_++;
+      }
+
+    //Writes the same data byte count times
+    static void data_fill(uint8_t d, uint8_t count) {
+      set_mode(mode_data);
+      for (uint8_t i = count; i; i--) {
+        Spi::wait();
+        Spi::write(d);
+        }
+      column_ += count;
+      }
+
+    //Waits until all bytes are sent and deselects the display
+    static void release() {
+      if (mode_ == mode_released)
+        return;
+      Spi::wait();
+      P::cs::high();
+      mode_ = mode_released;
+      }
+
+    //Cursor
+    static uint8_t get_position_page()   {return page_;}
+    static uint8_t get_position_column() {return column_;}
+
+    static void moveto_xy(uint8_t page, uint8_t column) {
+      Panel::template goto_address<Display,UpsideDown>(page, column);
+      column_ = column;
+      page_   = page;
+      }
+
+    static void move_xy(int8_t pages_, int16_t columns) {
+      moveto_xy((uint8_t)(page_ + pages_) % pages, column_ + columns);
+      }
+
+    //Draws an image from flash at the cursor, see lcd_draw_image_P
+    static void draw_image_P(PGM_VOID_P image, uint8_t img_pages, uint8_t columns, uint8_t style) {
+      PGM_P   src   = (PGM_P)image;
+      uint8_t inv   = (style & invert) ? 0xFF : 0;
+      uint8_t start = column_;
+      for (uint8_t j = 0; j < img_pages && page_ < pages; j++) {
+        for (uint8_t i = 0; i < columns; i++) {
+          uint8_t b = pgm_read_byte(src++);
+          if (column_ < width)
+            data(b ^ inv);
+          }
+        if (j + 1 != img_pages)
+          moveto_xy(page_ + 1, start);
+        }
+      release();
+      }
+
+    //Clears an area starting at the cursor, see lcd_clear_area
+    static void clear_area(uint8_t area_pages, uint8_t columns, uint8_t style) {
+      uint8_t inv = (style & invert) ? 0xFF : 0;
+      if (area_pages > pages - page_)
+        area_pages = pages - page_;
+      if (columns > width - column_)
+        columns = width - column_;
+      for (uint8_t j = 0; j < area_pages; j++) {
+        data_fill(inv, columns);
+        move_xy(1, -columns);
+        }
+      move_xy(-area_pages, 0);
+      release();
+      }
+
+    static void clear_area_xy(uint8_t area_pages, uint8_t columns, uint8_t style, uint8_t page, uint8_t col) {
+      moveto_xy(page, col);
+      clear_area(area_pages, columns, style);
+      }
+
+    //DOGXL240 only: contrast in percent
+    static void set_contrast(uint8_t value) {
+      Panel::template set_contrast<Display>(value);
+      release();
+      }
+
+  private:
+    enum {mode_released, mode_command, mode_data};
+    static uint8_t page_, column_, mode_;
+
+    //Selects the display and sets A0, see lcd_bus_set_mode
+    static void set_mode(uint8_t mode) {
+      if (mode_ == mode)
+        return;
+      if (mode_ == mode_released)
+        P::cs::low();
+      else
+        Spi::wait();
+      if (mode == mode_data)
+        P::a0::high();
+      else
+        P::a0::low();
+      mode_ = mode;
+      }
+  };
+
+template<class Panel, class P, class Spi, bool U> uint8_t Display<Panel,P,Spi,U>::page_   = 0;
+template<class Panel, class P, class Spi, bool U> uint8_t Display<Panel,P,Spi,U>::column_ = 0;
+template<class Panel, class P, class Spi, bool U> uint8_t Display<Panel,P,Spi,U>::mode_   = 0;
+
+}
+
+#endif
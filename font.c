@@ -24,8 +24,11 @@
  * 
  * Author:  Jan Michel (jan at mueschelsoft dot de)
  * License: GNU General Public License, version 3
- * Version: v0.94 October 2011
+ * Version: v0.95 October 2026
  * ****************************************************************************
+ * New features in v0.95
+ *   - vertical text (ROTATE_90, ROTATE_270), glyphs are transposed in blocks
+ *     of 8x8 pixels while they are written
  * New features in v0.94
  *   - Characters may now be bigger than 128 Byte and occupy more than 1024 Pixels each
  *   - Added 32px high digits (4 digits plus colon plus large spacing = 128px)
@@ -123,11 +126,13 @@ inline int16_t font_get_char_number(FONT_P font, char character) {
 
 /******************************************************************************
  * Read the width of the selected character from the font width table
+ * Characters not in a proportional font have no width
  */
 inline uint8_t font_get_char_width(FONT_P font, char character) {
   PGM_P table = font_widthtable(font);
+  int16_t charnum = font_get_char_number(font,character);
   if (table)
-    return pgm_read_byte(table+font_get_char_number(font,character));
+    return (charnum < 0) ? 0 : pgm_read_byte(table+charnum);
   else
     return pgm_read_byte(&font->width);
   }
@@ -142,10 +147,12 @@ PGM_P font_get_char_position(FONT_P font, char character) {
   uint8_t  charnum     = charnum_ret;
   PGM_P    base        = font_widthtable(font);
 
+  LCD_STAT_INC(glyphs);
   if (charnum_ret < 0)     //char not found
     return 0;
   if(base == 0)            //fixed width
     return font_data(font) + (uint16_t)charnum * (uint8_t)(font_get_height_bytes(font) * font_get_char_width(font,character));
+  LCD_STAT_ADD(width_bytes, charnum);
   if (charnum)             //proportional width
     while(charnum--)
       ret += (uint8_t) pgm_read_byte(base++);
@@ -173,10 +180,80 @@ inline unsigned char double_bits(uint8_t part, char c) {
  * Output functions for characters and strings
  *****************************************************************************/
 
+#if INCLUDE_ROTATED_TEXT == 1 && !defined(LCD_DOUBLE_PIXEL)
+/******************************************************************************
+ * Outputs a character rotated by 90 (top to bottom) or 270 degrees (bottom 
+ * to top). Each block of 8 x 8 pixels is prepared like font_put_char would 
+ * write it, transposed and written, so no buffer for the glyph is needed.
+ * The character box is 8 * font height wide. Its height is the width of the
+ * character, rounded up to full pages. The cursor is at the top left corner
+ * of the box (ROTATE_90) or below the bottom left corner (ROTATE_270) and 
+ * is moved to the position of the next character. WRAP is ignored.
+ */
+static uint8_t font_put_char_rotated(FONT_P font, uint8_t style, char character) {
+  uint8_t hc   = (style & DOUBLE_HEIGHT)?1:0; //height changed
+  uint8_t wc   = (style & DOUBLE_WIDTH)?1:0;  //width changed
+  uint8_t ul   = (style & UNDERLINE)?0x80:0x00;
+  uint8_t inv  = (style & INVERT)?0xFF:0;
+  uint8_t spc  = (style & SPACING)?3:1;
+  uint8_t cw   = (style & ROTATE_90)?1:0;     //clockwise
+  uint8_t src[8], dst[8];
+  uint8_t page, n, row, b, col, tmp;
+
+  LCD_STAT_INC(chars);
+
+  uint8_t char_width        = font_get_char_width(font,character);
+  uint8_t font_height       = font_get_height_bytes(font);
+  PGM_P   tableposition     = font_get_char_position(font,character);
+  uint8_t glyph_width       = tableposition ? (uint8_t)char_width << wc : 0;
+  uint8_t char_final_width  = (uint8_t)(char_width+spc) << wc;
+  uint8_t char_final_height = (uint8_t)font_height << hc;
+  uint8_t pages             = (char_final_width + 7) >> 3;
+
+  if (!cw)
+    LCD_MOVE(-pages,0);
+  for (page = 0; page < pages; page++) {
+    for (n = 0; n < char_final_height; n++) {
+      //rotated clockwise, the bottom row of the glyph is on the left
+      row = cw ? char_final_height-1-n : n;
+      for (b = 0; b < 8; b++) {
+        //rotated counter-clockwise, the first column is at the bottom
+        col = cw ? page*8 + b : pages*8-1 - page*8 - b;
+        if (col < glyph_width) {
+          tmp = pgm_read_byte(tableposition + (col>>wc)*font_height + (row>>hc));
+          if (row == char_final_height-1)
+            tmp |= ul;
+          if (hc)
+            tmp = double_bits((row&1),tmp);
+          tmp ^= inv;
+          }
+        else {
+          tmp = inv;
+          if (col < char_final_width && row == char_final_height-1) {
+            tmp ^= ul;
+            if (hc)
+              tmp ^= ul>>1;
+            }
+          }
+        src[b] = tmp;
+        }
+      LCD_TRANSPOSE(src, dst);
+      for (b = 0; b < 8; b++)
+        LCD_WRITE(dst[cw ? 7-b : b]);
+      }
+    LCD_MOVE(1,-8*char_final_height);
+    }
+  if (!cw)
+    LCD_MOVE(-pages,0);
+  return pages*8;
+  }
+#endif
+
 /******************************************************************************
  * Outputs a character on the display, using the given font and style
+ * Output may be buffered by the LCD library until LCD_FLUSH() is called
  */
-uint8_t lcd_put_char(FONT_P font, uint8_t style, char character) {
+static uint8_t font_put_char(FONT_P font, uint8_t style, char character) {
   uint16_t  i;
   uint8_t row  = 0;                             //current row of char
   #ifdef LCD_DOUBLE_PIXEL
@@ -190,6 +267,12 @@ uint8_t lcd_put_char(FONT_P font, uint8_t style, char character) {
   uint8_t spc  = (style & SPACING)?3:1;         //spacing
   uint8_t tmp;
 
+#if INCLUDE_ROTATED_TEXT == 1 && !defined(LCD_DOUBLE_PIXEL)
+  if (style & (ROTATE_90 | ROTATE_270))
+    return font_put_char_rotated(font,style,character);
+#endif
+  LCD_STAT_INC(chars);
+
   //load information about character
    uint8_t char_width    = font_get_char_width(font,character); 
    uint8_t font_height   = font_get_height_bytes(font);
@@ -201,8 +284,8 @@ uint8_t lcd_put_char(FONT_P font, uint8_t style, char character) {
   uint8_t char_final_height = (uint8_t)font_height << hc; 
 
   //check for avail. space on display
-  if ((style & WRAP) && (LCD_CURRENT_COL() + char_final_width > LCD_WIDTH)) {
-    LCD_MOVE_TO(LCD_CURRENT_PAGE()+char_final_height,0);
+  if ((style & WRAP) && (LCD_CURRENT_COL() + char_final_width > LCD_CURRENT_WIDTH())) {
+    LCD_NEXT_LINE(char_final_height);
     if (character == ' ') return 0;
     }
   
@@ -240,15 +323,30 @@ uint8_t lcd_put_char(FONT_P font, uint8_t style, char character) {
   }
 
 
+/******************************************************************************
+ * Outputs a character on the display, using the given font and style
+ */
+uint8_t lcd_put_char(FONT_P font, uint8_t style, char character) {
+  LCD_SPAN_BEGIN();
+  uint8_t width = font_put_char(font,style,character);
+  LCD_FLUSH();
+  LCD_SPAN_END(LCD_SPAN_TEXT);
+  return width;
+  }
+
+
 /******************************************************************************
  * Outputs a string on the display, loading it from the program memory,
  * using the given font and style
  */
 uint16_t lcd_put_string_P(FONT_P font, uint8_t style, PGM_P str) {
+  LCD_SPAN_BEGIN();
   unsigned char t;
   uint16_t length = 0;
   while((t = pgm_read_byte(str++))) 
-    length += lcd_put_char(font,style,t);
+    length += font_put_char(font,style,t);
+  LCD_FLUSH();
+  LCD_SPAN_END(LCD_SPAN_TEXT);
   return length;
   }
 
@@ -257,10 +355,13 @@ uint16_t lcd_put_string_P(FONT_P font, uint8_t style, PGM_P str) {
  * Outputs a string on the display, using the given font and style
  */
 uint16_t lcd_put_string(FONT_P font, uint8_t style, char* str) {
+  LCD_SPAN_BEGIN();
   unsigned char t;
   uint16_t length = 0;
   while((t = *str++))
-    length += lcd_put_char(font,style,t);
+    length += font_put_char(font,style,t);
+  LCD_FLUSH();
+  LCD_SPAN_END(LCD_SPAN_TEXT);
   return length;
   }
 
@@ -270,10 +371,13 @@ uint16_t lcd_put_string(FONT_P font, uint8_t style, char* str) {
  * length characters from the memory
  */ 
 uint16_t lcd_put_string_length(FONT_P font, uint8_t style, char* str, uint8_t length) {
+  LCD_SPAN_BEGIN();
   unsigned char t;
   uint16_t total_len = 0;
   for(t=0;t<length;t++)
-    total_len += lcd_put_char(font,style,*str++);
+    total_len += font_put_char(font,style,*str++);
+  LCD_FLUSH();
+  LCD_SPAN_END(LCD_SPAN_TEXT);
   return total_len;
   }
 
@@ -8,7 +8,12 @@
 #include <stdio.h>
 
 //Include your LCD graphics library here
-#include "dogm-graphic.h"
+//(define LCD_COLOR_GRAPHIC, e.g. on the command line, for lcd-color-graphic)
+#ifdef LCD_COLOR_GRAPHIC
+  #include "lcd-color-graphic.h"
+#else
+  #include "dogm-graphic.h"
+#endif
 //declare font info structure defined below
 struct font_info;
 typedef const struct font_info * FONT_P;
@@ -34,6 +39,12 @@ typedef const struct font_info * FONT_P;
 #define INCLUDE_FLOAT_OUTPUT     0
 #define INCLUDE_INTEGER_OUTPUT   1
 
+//Set to 1 to include vertical text (styles ROTATE_90, ROTATE_270, not for DOGXL160)
+//(the host and sim benchmarks set it on the command line)
+#ifndef INCLUDE_ROTATED_TEXT
+  #define INCLUDE_ROTATED_TEXT   0
+#endif
+
 
 /*****************************************************************************
  * All font structures + verbose name defines
@@ -83,11 +94,30 @@ typedef const struct font_info * FONT_P;
 
 #define LCD_MOVE(x,y)      lcd_move_xy((x),(y))     //relative cursor movement
 #define LCD_MOVE_TO(x,y)   lcd_moveto_xy((x),(y))   //absolute cursor movement
-#define LCD_WRITE(x)       lcd_data((x))            //write data to display
+#define LCD_TRANSPOSE(s,d) lcd_transpose_8x8((s),(d)) //8x8 pixels, for rotated text
+#ifndef LCD_COLOR_GRAPHIC
+  #define LCD_WRITE(x)     lcd_data((x))            //write data to display
+  #define LCD_FLUSH()      lcd_release()            //finish output of a string
+#else
+  #define LCD_WRITE(x)     lcd_write_font_byte((x))
+  #define LCD_FLUSH()      lcd_font_flush()
+#endif
 
 //Functions to read the current position as provided by the LCD library
 #define LCD_CURRENT_COL()   lcd_get_position_column()
 #define LCD_CURRENT_PAGE()  lcd_get_position_page()
+#ifndef LCD_COLOR_GRAPHIC
+  #define LCD_CURRENT_WIDTH() lcd_get_width()      //width of display or canvas
+#else
+  #define LCD_CURRENT_WIDTH() lcd_width            //width after lcd_set_rotation
+#endif
+
+//Start of the next line for WRAP, pages below the current one
+#ifndef LCD_COLOR_GRAPHIC
+  #define LCD_NEXT_LINE(p)   LCD_MOVE_TO(LCD_CURRENT_PAGE()+(p),0)
+#else
+  #define LCD_NEXT_LINE(p)   LCD_MOVE((p),-LCD_CURRENT_COL()) //keeps the pixel line
+#endif
 
 
 /******************************************************************************
@@ -158,6 +188,8 @@ uint16_t lcd_put_float (float integer);
 #define WRAP          8    //wrap around text that does not fit in the current line
 #define UNDERLINE    16    //underline the text
 #define SPACING      32    //increase spacing between character
+#define ROTATE_90    64    //vertical text, top to bottom (see font_put_char_rotated)
+#define ROTATE_270  128    //vertical text, bottom to top
 
 
 //used for internal functions:
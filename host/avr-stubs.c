@@ -0,0 +1,35 @@
+/******************************************************************************
+ * Registers and avr-libc functions needed on the host, see avr/io.h
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <avr/io.h>
+
+volatile uint8_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+volatile uint8_t DDRA,  DDRB,  DDRC,  DDRD,  DDRE,  DDRF;
+volatile uint8_t PINA,  PINB,  PINC,  PIND,  PINE,  PINF;
+volatile uint8_t PORTA_OUT, PORTB_OUT, PORTC_OUT, PORTD_OUT, PORTE_OUT, PORTF_OUT;
+volatile uint8_t PORTA_DIR, PORTB_DIR, PORTC_DIR, PORTD_DIR, PORTE_DIR, PORTF_DIR;
+volatile uint8_t SPDR, SPDR0, SPIF_DATA;
+USART_t USARTC0, USARTD0, USARTE0;
+
+//The bus is initialized by the host back-end
+void init_spi_lcd(void) {
+  }
+
+char *itoa(int value, char *s, int radix) {
+  sprintf(s, radix == 16 ? "%x" : "%d", value);
+  return s;
+  }
+
+char *ltoa(long value, char *s, int radix) {
+  sprintf(s, radix == 16 ? "%lx" : "%ld", value);
+  return s;
+  }
+
+char *utoa(unsigned int value, char *s, int radix) {
+  sprintf(s, radix == 16 ? "%x" : "%u", value);
+  return s;
+  }
@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Host stub for <avr/io.h>: I/O registers are plain variables, see 
+ * avr-stubs.c. Only registers used by the library configurations exist.
+ *****************************************************************************/
+#ifndef HOST_AVR_IO_H_INCLUDED
+#define HOST_AVR_IO_H_INCLUDED
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+//Classic AVR ports
+extern volatile uint8_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+extern volatile uint8_t DDRA,  DDRB,  DDRC,  DDRD,  DDRE,  DDRF;
+extern volatile uint8_t PINA,  PINB,  PINC,  PIND,  PINE,  PINF;
+
+//XMEGA ports
+extern volatile uint8_t PORTA_OUT, PORTB_OUT, PORTC_OUT, PORTD_OUT, PORTE_OUT, PORTF_OUT;
+extern volatile uint8_t PORTA_DIR, PORTB_DIR, PORTC_DIR, PORTD_DIR, PORTE_DIR, PORTF_DIR;
+
+//SPI, flags always read as set
+extern volatile uint8_t SPDR, SPDR0, SPIF_DATA;
+#define SPSR         0xFF
+#define SPSR0        0xFF
+#define SPIF_STATUS  0xFF
+#define SPIF         7
+#define SPIF0        7
+#define SPI_IF_bp    7
+
+//XMEGA USART
+typedef struct {
+  volatile uint8_t DATA;
+  volatile uint8_t STATUS;
+  } USART_t;
+extern USART_t USARTC0, USARTD0, USARTE0;
+#define USART_RXCIF_bm  0x80
+#define USART_TXCIF_bm  0x40
+#define USART_DREIF_bm  0x20
+
+//avr-libc extensions of <stdlib.h>, see avr-stubs.c
+char *itoa(int value, char *s, int radix);
+char *ltoa(long value, char *s, int radix);
+char *utoa(unsigned int value, char *s, int radix);
+
+#endif
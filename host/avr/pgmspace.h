@@ -0,0 +1,22 @@
+/******************************************************************************
+ * Host stub for <avr/pgmspace.h>: flash is ordinary memory
+ *****************************************************************************/
+#ifndef HOST_AVR_PGMSPACE_H_INCLUDED
+#define HOST_AVR_PGMSPACE_H_INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)             (s)
+typedef const char *        PGM_P;
+typedef const void *        PGM_VOID_P;
+typedef uint8_t             prog_uint8_t;
+
+#define pgm_read_byte(p)    (*(const uint8_t  *)(p))
+#define pgm_read_word(p)    (*(const uint16_t *)(p))
+#define pgm_read_dword(p)   (*(const uint32_t *)(p))
+#define memcpy_P            memcpy
+#define strlen_P            strlen
+
+#endif
@@ -0,0 +1,275 @@
+/******************************************************************************
+ * Bus traffic benchmark: runs a fixed workload through the host bus and
+ * counts bytes, chip selects and DC changes per operation. The counts are
+ * compared with a budget file, the program fails if any count is higher.
+ *
+ * Usage: bench-dog   [-w] budget-file
+ *        bench-color [-w] budget-file
+ *   -w            write the current counts to the budget file
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "font.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+#define BENCH_MAX_OPS  256
+
+typedef struct {
+  char     name[48];
+  uint32_t bytes, selects, dc_changes;
+  } bench_op_t;
+
+static bench_op_t bench_ops[BENCH_MAX_OPS];
+static int        bench_count;
+
+static const struct {const char *name; FONT_P font;} bench_fonts[] = {
+#ifdef FONTS_INCLUDE_font_fixed_8px
+  {"fixed8",    FONT_FIXED_8},
+#endif
+#ifdef FONTS_INCLUDE_font_fixed_16px
+  {"fixed16",   FONT_FIXED_16},
+#endif
+#ifdef FONTS_INCLUDE_font_proportional_8px
+  {"prop8",     FONT_PROP_8},
+#endif
+#ifdef FONTS_INCLUDE_font_proportional_16px
+  {"prop16",    FONT_PROP_16},
+#endif
+#ifdef FONTS_INCLUDE_symbols_8px
+  {"symbol8",   FONT_SYMBOL_8},
+#endif
+#ifdef FONTS_INCLUDE_symbols_16px
+  {"symbol16",  FONT_SYMBOL_16},
+#endif
+#ifdef FONTS_INCLUDE_digits_24px
+  {"digits24",  FONT_DIGITS_24},
+#endif
+#ifdef FONTS_INCLUDE_digits_32px
+  {"digits32",  FONT_DIGITS_32},
+#endif
+  };
+
+static const struct {const char *name; uint8_t style;} bench_styles[] = {
+  {"normal",    NORMAL},
+  {"dheight",   DOUBLE_HEIGHT},
+  {"dwidth",    DOUBLE_WIDTH},
+  {"invert",    INVERT},
+  {"wrap",      WRAP},
+  {"underline", UNDERLINE},
+  {"spacing",   SPACING},
+#if INCLUDE_ROTATED_TEXT == 1
+  {"rotate90",  ROTATE_90},
+  {"rotate270", ROTATE_270},
+#endif
+  };
+
+#define BENCH_TEXT "Quick fox 0123456789"
+
+
+/******************************************************************************
+ * Starts and ends the measurement of an operation. The mono display is 
+ * released first, so each operation includes selecting it.
+ */
+static void bench_start(void) {
+#ifndef LCD_COLOR_GRAPHIC
+  lcd_release();
+#endif
+  lcd_host_bus_reset();
+  }
+
+static void bench_end(const char *name) {
+  bench_op_t *op = &bench_ops[bench_count++];
+  snprintf(op->name, sizeof(op->name), "%s", name);
+  op->bytes      = lcd_host_bus_count.bytes;
+  op->selects    = lcd_host_bus_count.selects;
+  op->dc_changes = lcd_host_bus_count.dc_changes;
+  }
+
+
+/******************************************************************************
+ * The workload
+ */
+static void bench_text(void) {
+  char name[48];
+  for (unsigned f = 0; f < sizeof(bench_fonts)/sizeof(bench_fonts[0]); f++) {
+    for (unsigned s = 0; s < sizeof(bench_styles)/sizeof(bench_styles[0]); s++) {
+      //text rotated by 270 degrees starts below the box and goes upwards
+      lcd_moveto_xy((bench_styles[s].style & ROTATE_270) ? LCD_HEIGHT/8 : 0, 0);
+      bench_start();
+      lcd_put_string(bench_fonts[f].font, bench_styles[s].style, BENCH_TEXT);
+      snprintf(name, sizeof(name), "text/%s/%s", bench_fonts[f].name, bench_styles[s].name);
+      bench_end(name);
+      }
+    }
+  }
+
+#ifndef LCD_COLOR_GRAPHIC
+//2 pages x 32 columns
+static const uint8_t bench_image[64] PROGMEM = {
+  0x00, 0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x00, 0x3C, 0x42, 0x81, 0x81, 0x42, 0x3C,
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0xAA, 0x55, 0xAA, 0x55, 0x00, 0x00, 0xF0, 0x0F,
+  0xFF, 0x00, 0xFF, 0x00, 0x18, 0x24, 0x42, 0x81, 0x81, 0x42, 0x24, 0x18, 0x00, 0x00, 0x00, 0x00,
+  0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, 0x55, 0xAA, 0x55, 0xAA, 0xFF, 0xFF, 0x0F, 0xF0,
+  };
+
+static void bench_graphics(void) {
+  lcd_moveto_xy(1,8);
+  bench_start();
+  lcd_draw_image_P(bench_image, 2, 32, NORMAL);
+  bench_end("image/draw_P");
+
+  bench_start();
+  lcd_draw_image_xy_P(bench_image, 40, 12, 2, 32, NORMAL);
+  bench_end("image/draw_xy_P/unaligned");
+
+  bench_start();
+  lcd_draw_image_xy_P(bench_image, 40, 16, 2, 32, INVERT);
+  bench_end("image/draw_xy_P/aligned_invert");
+
+  lcd_moveto_xy(2,16);
+  bench_start();
+  lcd_clear_area(2, 64, NORMAL);
+  bench_end("clear/2x64");
+
+  lcd_moveto_xy(0,0);
+  bench_start();
+  lcd_clear_area(LCD_RAM_PAGES, LCD_WIDTH, NORMAL);
+  bench_end("clear/screen");
+  }
+
+#else
+//16x16 test images, one per encoding (the raw one is filled in at run time)
+static uint8_t bench_raw_image[5 + 2*16*16] = {LCD_IMAGE_RAW, 16, 0, 16, 0};
+static const uint8_t bench_rle_image[] PROGMEM = {
+  LCD_IMAGE_RLE, 16, 0, 16, 0,
+  0x03, 0xF8, 0x00, 0x07, 0xE0, 0x00, 0x1F, 0xFF, 0xFF,  //4 literal pixels
+  0xFE, 0xF8, 0x00,                                      //128 repeated
+  0xFA, 0x00, 0x1F,                                      //124 repeated
+  };
+static const uint8_t bench_palette_image[] PROGMEM = {
+  LCD_IMAGE_PALETTE, 16, 0, 16, 0,
+  2, 0xF8, 0x00, 0x00, 0x1F,
+  0x07, 0, 1, 0, 1, 0, 1, 0, 1,                          //8 literal pixels
+  0xFE, 0,                                               //128 repeated
+  0xF6, 1,                                               //120 repeated
+  };
+
+static void bench_graphics(void) {
+  color_t c = {10, 20, 30};
+
+  for (unsigned i = 5; i < sizeof(bench_raw_image); i++)
+    bench_raw_image[i] = i;
+  bench_start();
+  lcd_draw_image_xy_P(bench_raw_image, 10, 10);
+  bench_end("image/raw16x16");
+
+  bench_start();
+  lcd_draw_image_xy_P(bench_rle_image, 10, 10);
+  bench_end("image/rle16x16");
+
+  bench_start();
+  lcd_draw_image_xy_P(bench_palette_image, 10, 10);
+  bench_end("image/palette16x16");
+
+  bench_start();
+  lcd_set_area_xy(10, 109, 20, 119);
+  bench_end("area/100x100");
+
+  bench_start();
+  lcd_set_area_xy(0, LCD_WIDTH-1, 0, LCD_HEIGHT-1);
+  bench_end("area/screen");
+
+  bench_start();
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, c);
+  bench_end("fill/screen");
+
+  bench_start();
+  lcd_set_foreground(31, 63, 31);
+  lcd_set_background(0, 0, 0);
+  bench_end("colors");
+  }
+#endif
+
+
+/******************************************************************************
+ * Budget file: one line per operation with name, bytes, selects and DC 
+ * changes. Lines starting with # are comments.
+ */
+static int bench_write(const char *file) {
+  FILE *f = fopen(file, "w");
+  if (!f)
+    return 1;
+  fprintf(f, "# %-36s %8s %8s %8s\n", "operation", "bytes", "selects", "dc");
+  for (int i = 0; i < bench_count; i++)
+    fprintf(f, "%-38s %8lu %8lu %8lu\n", bench_ops[i].name, (unsigned long)bench_ops[i].bytes,
+            (unsigned long)bench_ops[i].selects, (unsigned long)bench_ops[i].dc_changes);
+  return fclose(f) ? 1 : 0;
+  }
+
+
+static int bench_check(const char *file) {
+  FILE *f = fopen(file, "r");
+  char  line[256], name[64];
+  unsigned long bytes, selects, dc;
+  int   found[BENCH_MAX_OPS] = {0};
+  int   failed = 0;
+  
+  if (!f) {
+    printf("cannot open budget file %s\n", file);
+    return 1;
+    }
+  printf("%-38s %8s %8s %8s\n", "operation", "bytes", "selects", "dc");
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || sscanf(line, "%63s %lu %lu %lu", name, &bytes, &selects, &dc) != 4)
+      continue;
+    for (int i = 0; i < bench_count; i++) {
+      bench_op_t *op = &bench_ops[i];
+      if (strcmp(op->name, name))
+        continue;
+      found[i] = 1;
+      if (op->bytes > bytes || op->selects > selects || op->dc_changes > dc) {
+        printf("%-38s %8lu %8lu %8lu  OVER BUDGET (%lu %lu %lu)\n", op->name, 
+               (unsigned long)op->bytes, (unsigned long)op->selects, 
+               (unsigned long)op->dc_changes, bytes, selects, dc);
+        failed = 1;
+        }
+      else {
+        printf("%-38s %8lu %8lu %8lu%s\n", op->name, (unsigned long)op->bytes,
+               (unsigned long)op->selects, (unsigned long)op->dc_changes,
+               (op->bytes < bytes || op->selects < selects || op->dc_changes < dc) ? 
+               "  below budget" : "");
+        }
+      }
+    }
+  fclose(f);
+  for (int i = 0; i < bench_count; i++) {
+    if (!found[i]) {
+      printf("%-38s no budget\n", bench_ops[i].name);
+      failed = 1;
+      }
+    }
+  printf(failed ? "FAILED\n" : "OK\n");
+  return failed;
+  }
+
+
+int main(int argc, char **argv) {
+  int write = (argc > 2 && !strcmp(argv[1], "-w"));
+  if (argc < 2 + write) {
+    printf("usage: %s [-w] budget-file\n", argv[0]);
+    return 2;
+    }
+#ifndef LCD_COLOR_GRAPHIC
+  lcd_emu_dog_attach();
+#else
+  lcd_emu_ili9341_attach();
+#endif
+  lcd_init();
+  bench_text();
+  bench_graphics();
+  return write ? bench_write(argv[2]) : bench_check(argv[1]);
+  }
@@ -0,0 +1,43 @@
+/******************************************************************************
+ * Host demo for lcd-color-graphic: renders text and shapes into the 
+ * emulated display RAM and saves it as color.ppm
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include "font.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+
+int main(int argc, char **argv) {
+  const char *file = (argc > 1) ? argv[1] : "color.ppm";
+  color_t navy = {0, 0, 12};
+
+  lcd_emu_ili9341_attach();
+  lcd_init();
+  lcd_host_bus_reset();
+
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, navy);
+  lcd_set_foreground(31, 63, 31);
+  lcd_set_background(0, 0, 12);
+  lcd_moveto_xy(0, 4);
+  lcd_put_string_P(FONT_PROP_16, NORMAL, PSTR("Hello, ILI9341!"));
+  lcd_set_text_mode(LCD_TEXT_TRANSPARENT);
+  lcd_moveto_pixel(4, 21);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("transparent text at line 21"));
+  lcd_set_text_mode(LCD_TEXT_OPAQUE);
+
+  lcd_set_foreground(31, 40, 0);
+  lcd_draw_rect(10, 40, 100, 60);
+  lcd_fill_round_rect(130, 40, 100, 60, 12);
+  lcd_set_foreground(0, 63, 0);
+  lcd_draw_line(10, 120, 230, 200);
+  lcd_draw_circle(60, 250, 40);
+  lcd_fill_circle(180, 250, 30);
+
+  printf("%lu bytes, %lu commands\n",
+         (unsigned long)lcd_host_bus_count.bytes, (unsigned long)lcd_host_bus_count.commands);
+  return lcd_emu_ili9341_save_ppm(file) ? 1 : 0;
+  }
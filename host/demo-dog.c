@@ -0,0 +1,43 @@
+/******************************************************************************
+ * Host demo for dogm-graphic: renders text and images into the emulated 
+ * display RAM and saves it as dog.pbm
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include "dogm-graphic.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+//8x8 checker pattern with a frame
+static const uint8_t checker[] PROGMEM = {
+  0xFF, 0x81, 0xA5, 0x81, 0x81, 0xA5, 0x81, 0xFF
+  };
+
+
+int main(int argc, char **argv) {
+  const char *file = (argc > 1) ? argv[1] : "dog.pbm";
+
+  lcd_emu_dog_attach();
+  lcd_init();
+  lcd_host_bus_reset();
+
+  lcd_moveto_xy(0,0);
+  lcd_put_string_P(FONT_PROP_8, NORMAL, PSTR("Hello, DOG!"));
+  lcd_moveto_xy(1,0);
+  lcd_put_string_P(FONT_FIXED_8, INVERT | UNDERLINE, PSTR("Invert"));
+  lcd_moveto_xy(2,0);
+  lcd_put_string_P(FONT_PROP_16, NORMAL, PSTR("Size 16"));
+  lcd_moveto_xy(4,0);
+  lcd_put_string_P(FONT_FIXED_8, DOUBLE_SIZE, PSTR("x2"));
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+  lcd_draw_image_xy_P(checker, 80, 3, 1, 8, NORMAL);
+  lcd_draw_image_xy_P(checker, 90, 8, 1, 8, INVERT);
+#endif
+  lcd_clear_area_xy(1, 8, INVERT, 0, LCD_WIDTH - 8);
+
+  printf("%lu bytes, %lu commands\n", 
+         (unsigned long)lcd_host_bus_count.bytes, (unsigned long)lcd_host_bus_count.commands);
+  return lcd_emu_dog_save_pbm(file) ? 1 : 0;
+  }
@@ -0,0 +1,215 @@
+/******************************************************************************
+ * Emulator for the controllers of the EA-DOG displays, see lcd-emu.h
+ * The controller is selected by DISPLAY_TYPE in dogm-graphic.h:
+ *   102: UC1701, 128/132: ST7565R, 160: UC1610 (2 bits per pixel), 
+ *   240: UC1611s
+ * Emulated: page and column address, auto-increment with wrap around,
+ * window program (UC1610/UC1611), start line and commands with an argument.
+ * Other commands (power, bias, contrast, mapping) are accepted and ignored.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "dogm-graphic.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+#if DISPLAY_TYPE == 160 || DISPLAY_TYPE == 240
+  #define EMU_UC161X    1
+  #define EMU_COLUMNS   LCD_WIDTH
+#else
+  #define EMU_UC161X    0
+  #define EMU_COLUMNS   132
+#endif
+#define EMU_LINES       (LCD_RAM_PAGES * LCD_PIXEL_PER_BYTE)
+#if DISPLAY_TYPE == 240
+  #define EMU_SHIFT     0
+#else
+  #define EMU_SHIFT     SHIFT_ADDR
+#endif
+
+static uint8_t emu_ram[LCD_RAM_PAGES][EMU_COLUMNS];
+
+static struct {
+  uint8_t page;
+  uint8_t column;
+  uint8_t start_line;
+  uint8_t wrap;           //column wraps to next page
+  uint8_t page_wrap;      //page wraps to first page (UC1701)
+  uint8_t window;         //window program enabled
+  uint8_t window_start_page, window_start_column;
+  uint8_t window_end_page,   window_end_column;
+  uint8_t argument_for;   //command waiting for its argument
+  } emu;
+
+
+/******************************************************************************
+ * Stores the argument of a two byte command
+ */
+static void emu_argument(uint8_t cmd, uint8_t arg) {
+  switch (cmd) {
+#if EMU_UC161X
+    case 0xF4: emu.window_start_column = arg; break;
+    case 0xF5: emu.window_start_page   = arg; break;
+    case 0xF6: emu.window_end_column   = arg; break;
+    case 0xF7: emu.window_end_page     = arg; break;
+#endif
+#if DISPLAY_TYPE == 102
+    case 0xFA: 
+      emu.wrap      = (arg & LCD_COLWRAP)  ? 1 : 0;
+      emu.page_wrap = (arg & LCD_PAGEWRAP) ? 1 : 0;
+      break;
+#endif
+    default: break;   //contrast, bias, indicator, booster, ...
+    }
+  }
+
+
+/******************************************************************************
+ * Executes a command byte
+ */
+static void emu_command(uint8_t c) {
+  if (emu.argument_for) {
+    emu_argument(emu.argument_for, c);
+    emu.argument_for = 0;
+    return;
+    }
+  if (c == 0xE2) {                      //system reset
+    memset(&emu, 0, sizeof(emu));
+    return;
+    }
+  if ((c & 0xF0) == 0x00) {             //column address LSB
+    emu.column = (emu.column & 0xF0) | (c & 0x0F);
+    return;
+    }
+  if ((c & 0xF0) == 0x10) {             //column address MSB
+    emu.column = (emu.column & 0x0F) | ((c & 0x0F) << 4);
+    return;
+    }
+#if EMU_UC161X
+  if ((c & 0xF0) == 0x40)               //start line LSB
+    emu.start_line = (emu.start_line & 0xF0) | (c & 0x0F);
+  else if ((c & 0xF8) == 0x50)          //start line MSB
+    emu.start_line = (emu.start_line & 0x0F) | ((c & 0x07) << 4);
+  #if DISPLAY_TYPE == 240
+  else if ((c & 0xF0) == 0x60)          //page address LSB
+    emu.page = (emu.page & 0xF0) | (c & 0x0F);
+  else if ((c & 0xF0) == 0x70)          //page address MSB
+    emu.page = (emu.page & 0x0F) | ((c & 0x0F) << 4);
+  else if (c == 0xC8)                   //N-line inversion
+    emu.argument_for = c;
+  #else
+  else if ((c & 0xE0) == 0x60)          //page address
+    emu.page = c & 0x1F;
+  else if ((c & 0xF0) == 0x30)          //advanced program control
+    emu.argument_for = c;
+  #endif
+  else if ((c & 0xF8) == 0x88)          //RAM address control
+    emu.wrap = c & 1;
+  else if ((c & 0xFE) == 0xF8)          //window program enable
+    emu.window = c & 1;
+  else if (c == 0x81 || (c >= 0xF1 && c <= 0xF7))
+    emu.argument_for = c;
+#else
+  if ((c & 0xC0) == 0x40)               //start line
+    emu.start_line = c & 0x3F;
+  else if ((c & 0xF0) == 0xB0)          //page address
+    emu.page = c & 0x0F;
+  #if DISPLAY_TYPE == 102
+  else if (c == 0x81 || c == 0xFA)
+    emu.argument_for = c;
+  #else
+  else if (c == 0x81 || c == 0xAC || c == 0xF8)
+    emu.argument_for = c;
+  #endif
+#endif
+  }
+
+
+/******************************************************************************
+ * Writes a data byte and advances the address
+ */
+static void emu_data(uint8_t d) {
+  uint8_t last_column = EMU_COLUMNS - 1;
+  uint8_t first_page  = 0, last_page = LCD_RAM_PAGES - 1;
+  if (emu.page < LCD_RAM_PAGES && emu.column < EMU_COLUMNS)
+    emu_ram[emu.page][emu.column] = d;
+#if EMU_UC161X
+  if (emu.window) {
+    last_column = emu.window_end_column;
+    first_page  = emu.window_start_page;
+    last_page   = emu.window_end_page;
+    }
+#endif
+  if (emu.column < last_column) {
+    emu.column++;
+    return;
+    }
+  if (!emu.wrap)                        //address stays at the last column
+    return;
+  emu.column = emu.window ? emu.window_start_column : 0;
+  if (emu.page < last_page)
+    emu.page++;
+  else if (EMU_UC161X || emu.page_wrap)
+    emu.page = first_page;
+  }
+
+
+static void emu_write(uint8_t b, uint8_t dc) {
+  if (dc)
+    emu_data(b);
+  else
+    emu_command(b);
+  }
+
+static const lcd_host_device_t emu_device = {emu_write, 0};
+
+
+/******************************************************************************
+ * Connects the emulator to the host bus and clears the display RAM
+ */
+void lcd_emu_dog_attach(void) {
+  memset(emu_ram, 0, sizeof(emu_ram));
+  memset(&emu, 0, sizeof(emu));
+  lcd_host_bus_attach(&emu_device);
+  }
+
+
+/******************************************************************************
+ * Returns a pixel as shown on the display, including the start line
+ * x, y          - position on the screen
+ * Returns 0 (clear) to 1 or 3 (set, depending on bits per pixel)
+ */
+uint8_t lcd_emu_dog_pixel(uint16_t x, uint16_t y) {
+  uint16_t line   = (y + emu.start_line) % EMU_LINES;
+  uint16_t column = x + EMU_SHIFT;
+  uint8_t  b;
+  if (x >= LCD_WIDTH || y >= LCD_HEIGHT || column >= EMU_COLUMNS)
+    return 0;
+  b = emu_ram[line / LCD_PIXEL_PER_BYTE][column];
+#if LCD_PIXEL_PER_BYTE == 4
+  return (b >> (2 * (line & 3))) & 3;
+#else
+  return (b >> (line & 7)) & 1;
+#endif
+  }
+
+
+/******************************************************************************
+ * Saves the screen as plain PBM image, set pixels are black
+ * Returns 0 on success
+ */
+int lcd_emu_dog_save_pbm(const char *filename) {
+  FILE *f = fopen(filename, "w");
+  if (!f)
+    return -1;
+  fprintf(f, "P1\n%d %d\n", LCD_WIDTH, LCD_HEIGHT);
+  for (uint16_t y = 0; y < LCD_HEIGHT; y++) {
+    for (uint16_t x = 0; x < LCD_WIDTH; x++)
+      fputc(lcd_emu_dog_pixel(x, y) ? '1' : '0', f);
+    fputc('\n', f);
+    }
+  return fclose(f);
+  }
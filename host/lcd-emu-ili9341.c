@@ -0,0 +1,224 @@
+/******************************************************************************
+ * Emulator for the ILI9341 controller, see lcd-emu.h
+ * Emulated: column and page address window, memory write and read (with 
+ * continue), MADCTL (row/column exchange and mirroring), vertical scrolling.
+ * Pixels are written in 16 bit format and read back in 18 bit format, like
+ * the controller does on the serial interface. Other commands are ignored 
+ * together with their arguments.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "lcd-color-graphic.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+//Display RAM in native orientation (portrait)
+static uint16_t emu_gram[LCD_HEIGHT][LCD_WIDTH];
+
+static struct {
+  uint8_t  cmd;                 //last command
+  uint32_t count;               //argument or data bytes received since
+  uint8_t  args[6];
+  uint16_t col0, col1;          //address window
+  uint16_t page0, page1;
+  uint16_t col, page;           //current address in window
+  uint8_t  madctl;
+  uint16_t scroll_top, scroll_height, scroll_start;
+  uint8_t  high;                //first byte of pixel
+  uint8_t  read[3];             //pixel being read
+  } emu;
+
+
+/******************************************************************************
+ * Returns the RAM cell for the current address, 0 if outside
+ */
+static uint16_t* emu_cell(void) {
+  uint16_t x = emu.col, y = emu.page;
+  if (emu.madctl & LCD_FLIP_XY) {
+    x = emu.page;
+    y = emu.col;
+    }
+  if (emu.madctl & LCD_MIRROR_X)
+    x = LCD_WIDTH - 1 - x;
+  if (emu.madctl & LCD_MIRROR_Y)
+    y = LCD_HEIGHT - 1 - y;
+  if (x >= LCD_WIDTH || y >= LCD_HEIGHT)
+    return 0;
+  return &emu_gram[y][x];
+  }
+
+
+/******************************************************************************
+ * Moves to the next address in the window
+ */
+static void emu_advance(void) {
+  if (emu.col < emu.col1) {
+    emu.col++;
+    return;
+    }
+  emu.col = emu.col0;
+  emu.page = (emu.page < emu.page1) ? emu.page + 1 : emu.page0;
+  }
+
+
+/******************************************************************************
+ * Handles a command byte
+ */
+static void emu_command(uint8_t c) {
+  emu.cmd   = c;
+  emu.count = 0;
+  emu.high  = 0;
+  switch (c) {
+    case LCD_SOFT_RESET:
+      emu.madctl = 0;
+      emu.scroll_top = 0;
+      emu.scroll_height = LCD_HEIGHT;
+      emu.scroll_start = 0;
+      break;
+    case LCD_WRITE_MEM:
+    case LCD_READ_MEM:
+      emu.col  = emu.col0;
+      emu.page = emu.page0;
+      break;
+    default: 
+      break;
+    }
+  }
+
+
+/******************************************************************************
+ * Handles a data byte for the last command
+ */
+static void emu_data(uint8_t d) {
+  uint16_t *cell;
+  uint32_t  n = emu.count++;
+  if (n < sizeof(emu.args))
+    emu.args[n] = d;
+  switch (emu.cmd) {
+    case LCD_SET_COLUMN:
+      if (n == 3) {
+        emu.col0 = (emu.args[0] << 8) | emu.args[1];
+        emu.col1 = (emu.args[2] << 8) | emu.args[3];
+        }
+      break;
+    case LCD_SET_PAGE:
+      if (n == 3) {
+        emu.page0 = (emu.args[0] << 8) | emu.args[1];
+        emu.page1 = (emu.args[2] << 8) | emu.args[3];
+        }
+      break;
+    case LCD_MIRROR:
+      if (n == 0)
+        emu.madctl = d;
+      break;
+    case LCD_SCROLL_DEFINE:
+      if (n == 5) {
+        emu.scroll_top    = (emu.args[0] << 8) | emu.args[1];
+        emu.scroll_height = (emu.args[2] << 8) | emu.args[3];
+        }
+      break;
+    case LCD_SCROLL_START:
+      if (n == 1)
+        emu.scroll_start = (emu.args[0] << 8) | emu.args[1];
+      break;
+    case LCD_WRITE_MEM:
+    case LCD_WRITE_CONTINUE:
+      if (!emu.high) {
+        emu.high = 1;
+        emu.args[0] = d;
+        break;
+        }
+      emu.high = 0;
+      if ((cell = emu_cell()))
+        *cell = (emu.args[0] << 8) | d;
+      emu_advance();
+      break;
+    default:
+      break;
+    }
+  }
+
+
+/******************************************************************************
+ * Returns the next byte of a memory read (or read continue): a dummy byte, 
+ * then red, green and blue (6 bits each, left aligned) for each pixel
+ */
+static uint8_t emu_read(void) {
+  uint16_t *cell, v;
+  uint32_t  n;
+  if (emu.cmd != LCD_READ_MEM && emu.cmd != LCD_READ_CONTINUE)
+    return 0;
+  n = emu.count++;
+  if (n == 0)
+    return 0;                     //dummy byte
+  n--;
+  if (n % 3 == 0) {
+    v = (cell = emu_cell()) ? *cell : 0;
+    emu.read[0] = (v >> 11) << 3;
+    emu.read[1] = ((v >> 5) & 0x3F) << 2;
+    emu.read[2] = (v & 0x1F) << 3;
+    emu_advance();
+    }
+  return emu.read[n % 3];
+  }
+
+
+static void emu_write(uint8_t b, uint8_t dc) {
+  if (dc)
+    emu_data(b);
+  else
+    emu_command(b);
+  }
+
+static const lcd_host_device_t emu_device = {emu_write, emu_read};
+
+
+/******************************************************************************
+ * Connects the emulator to the host bus and clears the display RAM
+ */
+void lcd_emu_ili9341_attach(void) {
+  memset(emu_gram, 0, sizeof(emu_gram));
+  memset(&emu, 0, sizeof(emu));
+  emu.col1  = LCD_WIDTH - 1;
+  emu.page1 = LCD_HEIGHT - 1;
+  emu.scroll_height = LCD_HEIGHT;
+  lcd_host_bus_attach(&emu_device);
+  }
+
+
+/******************************************************************************
+ * Returns a pixel as shown on the screen, i.e. after vertical scrolling, in
+ * native orientation
+ */
+uint16_t lcd_emu_ili9341_pixel(uint16_t x, uint16_t y) {
+  uint16_t top = emu.scroll_top, bottom = emu.scroll_top + emu.scroll_height;
+  if (x >= LCD_WIDTH || y >= LCD_HEIGHT)
+    return 0;
+  if (y >= top && y < bottom && emu.scroll_height)
+    y = top + (y - top + emu.scroll_start - top + emu.scroll_height) % emu.scroll_height;
+  return emu_gram[y][x];
+  }
+
+
+/******************************************************************************
+ * Saves the screen as binary PPM image
+ * Returns 0 on success
+ */
+int lcd_emu_ili9341_save_ppm(const char *filename) {
+  FILE *f = fopen(filename, "wb");
+  if (!f)
+    return -1;
+  fprintf(f, "P6\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT);
+  for (uint16_t y = 0; y < LCD_HEIGHT; y++) {
+    for (uint16_t x = 0; x < LCD_WIDTH; x++) {
+      uint16_t v = lcd_emu_ili9341_pixel(x, y);
+      fputc(((v >> 11) & 0x1F) * 255 / 31, f);
+      fputc(((v >> 5)  & 0x3F) * 255 / 63, f);
+      fputc(( v        & 0x1F) * 255 / 31, f);
+      }
+    }
+  return fclose(f);
+  }
@@ -0,0 +1,24 @@
+#ifndef LCD_EMU_H_INCLUDED
+#define LCD_EMU_H_INCLUDED
+
+/******************************************************************************
+ * Display controller emulators for host builds. Attach one of them to the
+ * host bus (lcd-host-bus.h) before calling lcd_init(). The emulated display
+ * RAM can be inspected per pixel or saved as PBM / PPM image.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <inttypes.h>
+
+//EA-DOG controllers (ST7565R, UC1701, UC1610, UC1611), type from dogm-graphic.h
+void    lcd_emu_dog_attach(void);
+uint8_t lcd_emu_dog_pixel(uint16_t x, uint16_t y);      //gray level, 0: clear
+int     lcd_emu_dog_save_pbm(const char *filename);
+
+//ILI9341, 16 bit colors, display RAM in native orientation
+void     lcd_emu_ili9341_attach(void);
+uint16_t lcd_emu_ili9341_pixel(uint16_t x, uint16_t y); //RGB565 as shown
+int      lcd_emu_ili9341_save_ppm(const char *filename);
+
+#endif
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * Bus back-end for host builds, see lcd-host-bus.h
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <string.h>
+#include "lcd-host-bus.h"
+
+lcd_host_bus_count_t lcd_host_bus_count;
+uint16_t lcd_host_log[LCD_HOST_LOG_SIZE];
+uint32_t lcd_host_log_length;
+
+static const lcd_host_device_t *lcd_host_device;
+static uint8_t lcd_host_dc = 0xFF;    //DC of last byte, 0xFF: none yet
+
+
+/******************************************************************************
+ * Connects a device to the bus, 0 to remove it
+ */
+void lcd_host_bus_attach(const lcd_host_device_t *device) {
+  lcd_host_device = device;
+  }
+
+
+/******************************************************************************
+ * Clears log and counters
+ */
+void lcd_host_bus_reset(void) {
+  memset(&lcd_host_bus_count, 0, sizeof(lcd_host_bus_count));
+  lcd_host_log_length = 0;
+  lcd_host_dc = 0xFF;
+  }
+
+
+/******************************************************************************
+ * Records a byte and passes it on to the device
+ * b             - the byte
+ * dc            - 1 for data, 0 for command
+ */
+void lcd_host_bus_write(uint8_t b, uint8_t dc) {
+  lcd_host_bus_count.bytes++;
+  if (!dc)
+    lcd_host_bus_count.commands++;
+  if (lcd_host_dc != 0xFF && lcd_host_dc != dc)
+    lcd_host_bus_count.dc_changes++;
+  lcd_host_dc = dc;
+  if (lcd_host_log_length < LCD_HOST_LOG_SIZE)
+    lcd_host_log[lcd_host_log_length++] = ((uint16_t)dc << 8) | b;
+  if (lcd_host_device && lcd_host_device->write)
+    lcd_host_device->write(b, dc);
+  }
+
+
+/******************************************************************************
+ * Reads a byte from the device, 0 if there is none
+ */
+uint8_t lcd_host_bus_read(void) {
+  lcd_host_bus_count.reads++;
+  if (lcd_host_device && lcd_host_device->read)
+    return lcd_host_device->read();
+  return 0;
+  }
+
+
+/******************************************************************************
+ * Counts chip select
+ * selected      - 1 when chip select is asserted, 0 when released
+ */
+void lcd_host_bus_select(uint8_t selected) {
+  if (selected)
+    lcd_host_bus_count.selects++;
+  }
@@ -0,0 +1,45 @@
+#ifndef LCD_HOST_BUS_H_INCLUDED
+#define LCD_HOST_BUS_H_INCLUDED
+
+/******************************************************************************
+ * Bus back-end for host builds (LCD_TRANSPORT_HOST in lcd-transport.h)
+ * Records all bytes sent to the display and passes them on to an optional
+ * device, e.g. a display emulator.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <inttypes.h>
+
+//Number of bytes kept in the log, older bytes are counted only
+#define LCD_HOST_LOG_SIZE  65536
+
+typedef struct {
+  uint32_t bytes;       //all bytes
+  uint32_t commands;    //bytes sent with DC low
+  uint32_t reads;       //bytes read
+  uint32_t selects;     //chip select asserted
+  uint32_t dc_changes;  //DC changed between two bytes
+  } lcd_host_bus_count_t;
+
+//Device connected to the bus
+typedef struct {
+  void    (*write)(uint8_t b, uint8_t dc);
+  uint8_t (*read)(void);
+  } lcd_host_device_t;
+
+extern lcd_host_bus_count_t lcd_host_bus_count;
+
+//Log entries: byte in bits 0..7, DC in bit 8
+extern uint16_t lcd_host_log[LCD_HOST_LOG_SIZE];
+extern uint32_t lcd_host_log_length;
+
+void lcd_host_bus_attach(const lcd_host_device_t *device);
+void lcd_host_bus_reset(void);
+
+//Called by the display library
+void    lcd_host_bus_write(uint8_t b, uint8_t dc);
+uint8_t lcd_host_bus_read(void);
+void    lcd_host_bus_select(uint8_t selected);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef LCD_HOST_HPP_H_INCLUDED
+#define LCD_HOST_HPP_H_INCLUDED
+
+/******************************************************************************
+ * dogm-graphic.hpp on the host bus: pins and SPI interface writing to
+ * lcd-host-bus, and the display of DISPLAY_TYPE and ORIENTATION_UPSIDEDOWN
+ * as configured for the C library (used by test-hpp.cpp and size-hpp.cpp)
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+extern "C" {
+#include "dogm-graphic.h"
+#include "lcd-host-bus.h"
+}
+#include "dogm-graphic.hpp"
+
+//Pins and SPI interface of the template on the host bus
+struct HostA0 {
+  static uint8_t level;     //defined in the program
+  static void    output() {}
+  static void    high()   {level = 1;}
+  static void    low()    {level = 0;}
+  static uint8_t get()    {return level;}
+  };
+
+struct HostCS {
+  static void    output() {}
+  static void    high()   {lcd_host_bus_select(0);}
+  static void    low()    {lcd_host_bus_select(1);}
+  static uint8_t get()    {return 0;}
+  };
+
+struct HostSpi {
+  static void init()            {}
+  static void wait()            {}
+  static void write(uint8_t b)  {lcd_host_bus_write(b, HostA0::level);}
+  };
+
+#if   DISPLAY_TYPE == 102
+  typedef dogm::DOGS102  Panel;
+#elif DISPLAY_TYPE == 128
+  typedef dogm::DOGM128  Panel;
+#elif DISPLAY_TYPE == 132
+  typedef dogm::DOGM132  Panel;
+#elif DISPLAY_TYPE == 160
+  typedef dogm::DOGXL160 Panel;
+#elif DISPLAY_TYPE == 240
+  typedef dogm::DOGXL240 Panel;
+#endif
+
+typedef dogm::Display<Panel, dogm::Pins<HostA0, dogm::NoPin, HostCS>, HostSpi,
+                      ORIENTATION_UPSIDEDOWN == 1> Hpp;
+
+#endif
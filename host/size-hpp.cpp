@@ -0,0 +1,38 @@
+/******************************************************************************
+ * Code size of dogm-graphic.hpp against the C library: the same workload,
+ * built with SIZE_HPP=0 through the C functions (linked with dogm-graphic.c)
+ * and with SIZE_HPP=1 through the template. "make size" prints both.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include "lcd-host-hpp.h"
+
+uint8_t HostA0::level;
+
+//2 pages x 16 columns
+static const uint8_t size_image[32] PROGMEM = {
+  0x00, 0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x00, 0x3C, 0x42, 0x81, 0x81, 0x42, 0x3C,
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0xAA, 0x55, 0xAA, 0x55, 0x00, 0x00, 0xF0, 0x0F,
+  };
+
+int main(void) {
+#if SIZE_HPP == 1
+  Hpp::init();
+  Hpp::moveto_xy(1, 10);
+  Hpp::draw_image_P(size_image, 2, 16, dogm::normal);
+  Hpp::clear_area_xy(2, 20, dogm::invert, 3, 5);
+  Hpp::moveto_xy(0, 0);
+  Hpp::data(0x5A);
+  Hpp::release();
+#else
+  lcd_init();
+  lcd_moveto_xy(1, 10);
+  lcd_draw_image_P(size_image, 2, 16, NORMAL);
+  lcd_clear_area_xy(2, 20, INVERT, 3, 5);
+  lcd_moveto_xy(0, 0);
+  lcd_data(0x5A);
+  lcd_release();
+#endif
+  return 0;
+  }
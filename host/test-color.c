@@ -0,0 +1,664 @@
+/******************************************************************************
+ * Host tests for lcd-color-graphic: draws into the emulated ILI9341 and
+ * checks the cursor and the pixels shown. Best with -fsanitize=address
+ * (see Makefile).
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "font.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+static int test_failed;
+
+static void test_check(int ok, const char *what) {
+  printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok)
+    test_failed = 1;
+  }
+
+
+/******************************************************************************
+ * WRAP uses the width after lcd_set_rotation, not LCD_WIDTH
+ */
+static void test_wrap_rotated(void) {
+  lcd_set_rotation(LCD_ROTATE_90);
+  test_check(lcd_width == 320, "rotation: width swapped");
+  lcd_moveto_xy(0, 230);
+  lcd_put_string_P(FONT_FIXED_8, WRAP, PSTR("ABCD"));
+  test_check(lcd_get_position_page() == 0, "rotation: no wrap before the rotated width");
+  test_check(lcd_get_position_column() > 230, "rotation: cursor after the text");
+  lcd_set_rotation(LCD_ROTATE_0);
+  }
+
+
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+/******************************************************************************
+ * Images: RLE and palette tokens are decoded into one address window, runs
+ * continue on the next row, clipped pixels are skipped
+ */
+//5 x 3: a run of 7 into the second row, 5 literals, a run of 3
+#define TEST_RED    0xF8, 0x00
+#define TEST_GREEN  0x07, 0xE0
+#define TEST_BLUE   0x00, 0x1F
+static const uint8_t test_rle[] PROGMEM = {
+  LCD_IMAGE_RLE, 5, 0, 3, 0,
+  0x85, TEST_RED,
+  0x04, TEST_GREEN, TEST_BLUE, 0x12, 0x34, TEST_GREEN, TEST_BLUE,
+  0x81, 0xFF, 0xFF,
+  };
+static const uint16_t test_rle_pixels[15] = {
+  0xF800, 0xF800, 0xF800, 0xF800, 0xF800,
+  0xF800, 0xF800, 0x07E0, 0x001F, 0x1234,
+  0x07E0, 0x001F, 0xFFFF, 0xFFFF, 0xFFFF,
+  };
+
+//16 x 17, 256 colors (count byte 0): literals of all indices, a run of 16
+static uint8_t test_palette_image[5 + 1 + 512 + 2*129 + 2];
+
+static uint16_t test_palette_color(uint8_t i) {
+  return (uint16_t)(i * 0x0101) ^ 0x5A3C;
+  }
+
+static int test_image_shown(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels,
+                            uint16_t image_w) {
+  for (uint16_t j = 0; j < h; j++)
+    for (uint16_t i = 0; i < w; i++)
+      if (lcd_emu_ili9341_pixel(x + i, y + j) != pixels[j * image_w + i])
+        return 0;
+  return 1;
+  }
+
+static void test_image(void) {
+  uint16_t pixels[16*17], i;
+  uint8_t *p = test_palette_image;
+
+  lcd_fill_rect(0, 0, lcd_width, lcd_height, (color_t){0, 0, 0});
+  lcd_draw_image_xy_P(test_rle, 10, 10);
+  test_check(test_image_shown(10, 10, 5, 3, test_rle_pixels, 5) &&
+             lcd_emu_ili9341_pixel(15, 10) == 0 && lcd_emu_ili9341_pixel(10, 13) == 0,
+             "image: RLE runs across rows, literals");
+
+  //right and bottom edge: 3 x 2 pixels visible
+  lcd_draw_image_xy_P(test_rle, lcd_width - 3, lcd_height - 2);
+  test_check(test_image_shown(lcd_width - 3, lcd_height - 2, 3, 2, test_rle_pixels, 5) &&
+             lcd_emu_ili9341_pixel(0, lcd_height - 1) == 0, "image: RLE clipped at the edges");
+
+  *p++ = LCD_IMAGE_PALETTE; *p++ = 16; *p++ = 0; *p++ = 17; *p++ = 0;
+  *p++ = 0;
+  for (i = 0; i < 256; i++) {
+    *p++ = test_palette_color(i) >> 8;
+    *p++ = test_palette_color(i);
+    }
+  for (i = 0; i < 256; i++) {
+    if (!(i & 127))
+      *p++ = 127;
+    *p++ = i;
+    pixels[i] = test_palette_color(i);
+    }
+  *p++ = 0x80 + 14;
+  *p++ = 200;
+  for (i = 256; i < 16*17; i++)
+    pixels[i] = test_palette_color(200);
+  lcd_draw_image_xy_P(test_palette_image, 40, 40);
+  test_check(test_image_shown(40, 40, 16, 17, pixels, 16) && lcd_emu_ili9341_pixel(40, 57) == 0,
+             "image: palette of 256 colors (count byte 0)");
+  lcd_fill_rect(0, 0, lcd_width, lcd_height, (color_t){0, 0, 0});
+  }
+#endif
+
+
+/******************************************************************************
+ * Drawing primitives: lines, circles and spans give the same pixels as the
+ * plain algorithms, point by point, also when clipped at the screen edges
+ */
+static uint8_t test_ref[LCD_HEIGHT][LCD_WIDTH];  //expected pixels, rotation 0
+
+static void test_ref_set(int16_t x, int16_t y) {
+  if (x >= 0 && y >= 0 && x < LCD_WIDTH && y < LCD_HEIGHT)
+    test_ref[y][x] = 1;
+  }
+
+//Clears screen and reference
+static void test_ref_clear(void) {
+  memset(test_ref, 0, sizeof(test_ref));
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  }
+
+static int test_ref_shown(void) {
+  for (uint16_t y = 0; y < LCD_HEIGHT; y++)
+    for (uint16_t x = 0; x < LCD_WIDTH; x++)
+      if (lcd_emu_ili9341_pixel(x, y) != (test_ref[y][x] ? 0xFFFF : 0))
+        return 0;
+  return 1;
+  }
+
+static void test_ref_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int16_t err = dx + dy, e2;
+  for (;;) {
+    test_ref_set(x0, y0);
+    if (x0 == x1 && y0 == y1)
+      break;
+    e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+  }
+
+//Quarter circles around (cx0,cy0) ... (cx1,cy1), connected by lines
+static void test_ref_arcs(int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1, int16_t r) {
+  int16_t x = 0, y = r, f = 1 - r;
+  test_ref_line(cx0, cy0 - r, cx1, cy0 - r);
+  test_ref_line(cx0, cy1 + r, cx1, cy1 + r);
+  test_ref_line(cx0 - r, cy0, cx0 - r, cy1);
+  test_ref_line(cx1 + r, cy0, cx1 + r, cy1);
+  while (x <= y) {
+    test_ref_set(cx1 + x, cy1 + y); test_ref_set(cx0 - x, cy1 + y);
+    test_ref_set(cx1 + x, cy0 - y); test_ref_set(cx0 - x, cy0 - y);
+    test_ref_set(cx1 + y, cy1 + x); test_ref_set(cx0 - y, cy1 + x);
+    test_ref_set(cx1 + y, cy0 - x); test_ref_set(cx0 - y, cy0 - x);
+    if (f < 0) {
+      f += 2*x + 3;
+      }
+    else {
+      f += 2*(x - y) + 5;
+      y--;
+      }
+    x++;
+    }
+  }
+
+static void test_ref_filled_arcs(int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1, int16_t r) {
+  int16_t dx, dy;
+  for (int16_t y = cy0 - r; y <= cy1 + r; y++)
+    for (int16_t x = cx0 - r; x <= cx1 + r; x++) {
+      dx = (x < cx0) ? cx0 - x : (x > cx1) ? x - cx1 : 0;
+      dy = (y < cy0) ? cy0 - y : (y > cy1) ? y - cy1 : 0;
+      if ((int32_t)dx*dx + (int32_t)dy*dy <= (int32_t)r*r + r)
+        test_ref_set(x, y);
+      }
+  }
+
+static void test_primitives(void) {
+  static const int16_t lines[][4] = {
+    {10, 10, 60, 25}, {60, 25, 10, 10}, {10, 10, 25, 60}, {25, 60, 10, 10},
+    {30, 30, 50, 50}, {50, 30, 30, 50}, {70, 70, 70, 70}, {80, 5, 80, 40},
+    {-20, -8, 30, 40}, {LCD_WIDTH-10, 100, LCD_WIDTH+30, 112},
+    {5, LCD_HEIGHT+10, 40, LCD_HEIGHT-20}, {-5, 200, LCD_WIDTH+5, 203},
+    };
+  static const int16_t circles[][3] = {
+    {120, 160, 1}, {120, 160, 17}, {0, 0, 12}, {LCD_WIDTH-3, LCD_HEIGHT-4, 20},
+    };
+  int ok = 1;
+  uint8_t i;
+
+  lcd_set_foreground(31, 63, 31);
+  for (i = 0; i < sizeof(lines)/sizeof(lines[0]); i++) {
+    test_ref_clear();
+    test_ref_line(lines[i][0], lines[i][1], lines[i][2], lines[i][3]);
+    lcd_draw_line(lines[i][0], lines[i][1], lines[i][2], lines[i][3]);
+    ok &= test_ref_shown();
+    if (i == 7)
+      test_check(ok, "primitives: line runs, both directions, endpoints");
+    }
+  test_check(ok, "primitives: lines clipped at the edges");
+
+  //51 pixels on 16 rows: one window (11 bytes) per run
+  lcd_host_bus_reset();
+  lcd_draw_line(10, 10, 60, 25);
+  test_check(lcd_host_bus_count.bytes == 16*11 + 2*51, "primitives: one window per run");
+
+  for (ok = 1, i = 0; i < sizeof(circles)/sizeof(circles[0]); i++) {
+    test_ref_clear();
+    test_ref_arcs(circles[i][0], circles[i][1], circles[i][0], circles[i][1], circles[i][2]);
+    lcd_draw_circle(circles[i][0], circles[i][1], circles[i][2]);
+    ok &= test_ref_shown();
+    test_ref_clear();
+    test_ref_filled_arcs(circles[i][0], circles[i][1], circles[i][0], circles[i][1], circles[i][2]);
+    lcd_fill_circle(circles[i][0], circles[i][1], circles[i][2]);
+    ok &= test_ref_shown();
+    }
+  test_check(ok, "primitives: arcs of circles, also clipped");
+
+  //40 x 30, radius 8, and clipped at the top left corner
+  test_ref_clear();
+  test_ref_arcs(108, 58, 139, 79, 8);
+  test_ref_arcs(-2, -3, 20, 10, 6);
+  lcd_draw_round_rect(100, 50, 48, 38, 8);
+  lcd_draw_round_rect(-8, -9, 35, 26, 6);
+  ok = test_ref_shown();
+  test_ref_clear();
+  test_ref_filled_arcs(108, 58, 139, 79, 8);
+  test_ref_filled_arcs(-2, -3, 20, 10, 6);
+  lcd_fill_round_rect(100, 50, 48, 38, 8);
+  lcd_fill_round_rect(-8, -9, 35, 26, 6);
+  test_check(ok && test_ref_shown(), "primitives: rounded rectangles, also clipped");
+
+  test_ref_clear();
+  for (i = 0; i < 5; i++) {
+    test_ref_set(i, 3);
+    test_ref_set(LCD_WIDTH - 1, LCD_HEIGHT - 1 - i);
+    }
+  lcd_draw_hline(-5, 3, 10);
+  lcd_draw_vline(LCD_WIDTH - 1, LCD_HEIGHT - 5, 10);
+  lcd_draw_hline(-5, -1, 20);
+  lcd_draw_vline(LCD_WIDTH, 0, 20);
+  lcd_draw_hline(3, 5, 0);
+  test_check(test_ref_shown(), "primitives: spans clipped, empty spans");
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  }
+
+
+/******************************************************************************
+ * Transparent text: only set pixels are written, LCD_TEXT_AUTO picks the
+ * path with fewer bytes
+ */
+static uint8_t test_glyph[64];   //font bytes read back from the screen
+
+//Draws text opaque (white on black) and reads the font bytes, returns count
+static uint8_t test_text_bytes(PGM_P text) {
+  uint8_t n, b;
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  lcd_moveto_pixel(20, 30);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, text);
+  lcd_font_flush();
+  for (n = 0; 20 + n < lcd_get_position_column(); n++)
+    for (test_glyph[n] = 0, b = 0; b < 8; b++)
+      if (lcd_emu_ili9341_pixel(20 + n, 30 + b))
+        test_glyph[n] |= 1 << b;
+  return n;
+  }
+
+//Bytes of lcd_font_flush_transparent for the rows in mask: 5 per column,
+//6 per run and 2 per pixel
+static uint16_t test_transparent_cost(uint8_t n, uint8_t mask) {
+  uint16_t cost = 0;
+  uint8_t  b, r, prev;
+  for (uint8_t i = 0; i < n; i++) {
+    b = test_glyph[i] & mask;
+    if (b)
+      cost += 5;
+    for (prev = 0, r = 0; r < 8; r++, b >>= 1) {
+      if ((b & 1) && !prev)
+        cost += 6;
+      if (b & 1)
+        cost += 2;
+      prev = b & 1;
+      }
+    }
+  return cost;
+  }
+
+//Draws the text over red at row y in the given mode, checks bytes and pixels
+static int test_text_mode(PGM_P text, uint8_t n, uint16_t y, uint8_t mode, uint8_t transparent, uint16_t bytes) {
+  uint16_t red = lcd_pack_color((color_t){31, 0, 0}), v;
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){31, 0, 0});
+  lcd_set_text_mode(mode);
+  lcd_moveto_pixel(20, y);
+  lcd_host_bus_reset();
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, text);
+  lcd_font_flush();
+  lcd_set_text_mode(LCD_TEXT_OPAQUE);
+  if (lcd_host_bus_count.bytes != bytes)
+    return 0;
+  for (uint8_t i = 0; i < n; i++)
+    for (uint8_t b = 0; b < 8 && y + b < LCD_HEIGHT; b++) {
+      v = lcd_emu_ili9341_pixel(20 + i, y + b);
+      if ((test_glyph[i] >> b) & 1 ? v != 0xFFFF : v != (transparent ? red : 0))
+        return 0;
+      }
+  return lcd_emu_ili9341_pixel(20 + n, y) == red && lcd_emu_ili9341_pixel(19, y) == red;
+  }
+
+static void test_text_transparent(void) {
+  uint8_t  n;
+  uint16_t transparent, opaque;
+
+  lcd_set_foreground(31, 63, 31);
+  lcd_set_background(0, 0, 0);
+  n = test_text_bytes(PSTR("-.-"));
+  transparent = test_transparent_cost(n, 0xFF);
+  opaque      = 11 + 2*8*n;
+  test_check(test_text_mode(PSTR("-.-"), n, 30, LCD_TEXT_TRANSPARENT, 1, transparent),
+             "text: transparent, only set pixels written");
+  test_check(transparent < opaque && test_text_mode(PSTR("-.-"), n, 30, LCD_TEXT_AUTO, 1, transparent),
+             "text: auto mode, sparse glyphs transparent");
+
+  n = test_text_bytes(PSTR("B8B"));
+  transparent = test_transparent_cost(n, 0xFF);
+  opaque      = 11 + 2*8*n;
+  test_check(transparent >= opaque && test_text_mode(PSTR("B8B"), n, 30, LCD_TEXT_AUTO, 0, opaque),
+             "text: auto mode, dense glyphs opaque");
+
+  //3 rows left at the bottom: only those are written, and counted
+  transparent = test_transparent_cost(n, 0x07);
+  test_check(test_text_mode(PSTR("B8B"), n, LCD_HEIGHT - 3, LCD_TEXT_TRANSPARENT, 1, transparent) &&
+             lcd_emu_ili9341_pixel(20, 0) == lcd_pack_color((color_t){31, 0, 0}),
+             "text: transparent, cut at the bottom");
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  }
+
+
+/******************************************************************************
+ * lcd_plot_points: points are sorted, duplicates and adjacent points become
+ * one run per window, points outside the screen are clipped
+ */
+static void test_plot_points(void) {
+  lcd_point_t points[] = {
+    {5, 10}, {3, 10}, {4, 10}, {4, 10}, {20, 10}, {7, 12}, {-1, 12}, {0, 12},
+    {LCD_WIDTH, 12}, {LCD_WIDTH-1, 12}, {2, -3}, {2, LCD_HEIGHT}, {7, 12},
+    };
+  uint16_t count = sizeof(points)/sizeof(points[0]);
+  uint16_t x, y, set = 0;
+  int ok = 1;
+
+  lcd_set_foreground(31, 63, 31);
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  lcd_host_bus_reset();
+  lcd_plot_points(points, count);
+  for (uint16_t i = 1; i < count; i++)
+    ok &= points[i-1].y < points[i].y || (points[i-1].y == points[i].y && points[i-1].x <= points[i].x);
+  test_check(ok && points[0].y == -3 && points[count-1].y == LCD_HEIGHT, "plot points: sorted by row and column");
+
+  //row 10: runs 3..5 and 20; row 12: runs 0 (clipped), 7 (twice) and the
+  //last column (clipped). Page window per row, column window per run.
+  test_check(lcd_host_bus_count.bytes == 2*5 + 5*(5+1) + 2*(3+1+1+1+1),
+             "plot points: one window per run, duplicates merged");
+  for (y = 0; y < LCD_HEIGHT; y++)
+    for (x = 0; x < LCD_WIDTH; x++)
+      if (lcd_emu_ili9341_pixel(x, y))
+        set++;
+  test_check(set == 7 && lcd_emu_ili9341_pixel(3, 10) && lcd_emu_ili9341_pixel(5, 10) &&
+             lcd_emu_ili9341_pixel(20, 10) && lcd_emu_ili9341_pixel(0, 12) &&
+             lcd_emu_ili9341_pixel(7, 12) && lcd_emu_ili9341_pixel(LCD_WIDTH-1, 12),
+             "plot points: pixels shown, clipped at the edges");
+  lcd_plot_points(points, 0);
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  }
+
+
+#if LCD_USE_READBACK == 1
+/******************************************************************************
+ * Blending reads the display memory back: compare with the emulated memory.
+ * Expected channels: fg*a/15 + d*(15-a)/15, with /15 done as *17/256
+ */
+static uint8_t test_blend_channel(uint8_t fg, uint8_t d, uint8_t a) {
+  return ((fg * a * 17) >> 8) + ((d * (15 - a) * 17) >> 8);
+  }
+
+static uint16_t test_blend(color_t fg, color_t d, uint8_t a) {
+  color_t r = {test_blend_channel(fg.red, d.red, a), test_blend_channel(fg.green, d.green, a),
+               test_blend_channel(fg.blue, d.blue, a)};
+  return lcd_pack_color(r);
+  }
+
+static const uint8_t test_alpha_map[] PROGMEM = {0xF0, 0x00, 0x08, 0x00};  //0,15,0 / 8,0,0
+
+static void test_readback(void) {
+  color_t  bg = {10, 40, 20}, fg = {31, 8, 3};
+  uint16_t row[40];
+  uint16_t x, y, bad = 0;
+
+  lcd_fill_rect(10, 10, 40, 4, bg);
+  lcd_fill_rect(20, 11, 3, 1, fg);
+  lcd_read_row(5, 11, 40, row);
+  for (x = 0; x < 40; x++)
+    if (row[x] != lcd_emu_ili9341_pixel(5+x, 11))
+      bad++;
+  test_check(!bad, "readback: lcd_read_row matches display memory");
+
+  //40 pixels wide: two parts of LCD_READBACK_BUFFER
+  lcd_fill_rect(20, 11, 3, 1, bg);
+  lcd_blend_rect(10, 10, 40, 4, fg, 8);
+  for (bad = 0, y = 10; y < 14; y++)
+    for (x = 10; x < 50; x++)
+      if (lcd_emu_ili9341_pixel(x, y) != test_blend(fg, bg, 8))
+        bad++;
+  test_check(!bad, "readback: lcd_blend_rect alpha 8");
+  test_check(lcd_emu_ili9341_pixel(9, 10) == 0 && lcd_emu_ili9341_pixel(50, 13) == 0,
+             "readback: lcd_blend_rect stays in the rectangle");
+
+  lcd_fill_rect(10, 10, 40, 4, bg);
+  lcd_blend_rect(10, 10, 2, 1, fg, 0);
+  lcd_blend_rect(12, 10, 2, 1, fg, 15);
+  test_check(lcd_emu_ili9341_pixel(10, 10) == lcd_pack_color(bg) &&
+             lcd_emu_ili9341_pixel(13, 10) == lcd_pack_color(fg), "readback: alpha 0 and 15");
+
+  //3 pixels, 2 rows: each row of the map starts with a new byte
+  lcd_fill_rect(10, 10, 40, 4, bg);
+  lcd_blend_alpha_P(test_alpha_map, 10, 10, 3, 2, fg);
+  test_check(lcd_emu_ili9341_pixel(10, 10) == lcd_pack_color(bg) &&
+             lcd_emu_ili9341_pixel(11, 10) == lcd_pack_color(fg) &&
+             lcd_emu_ili9341_pixel(12, 10) == lcd_pack_color(bg) &&
+             lcd_emu_ili9341_pixel(10, 11) == test_blend(fg, bg, 8) &&
+             lcd_emu_ili9341_pixel(11, 11) == lcd_pack_color(bg) &&
+             lcd_emu_ili9341_pixel(13, 10) == lcd_pack_color(bg), "readback: lcd_blend_alpha_P map");
+  lcd_fill_rect(10, 10, 40, 4, (color_t){0, 0, 0});
+  }
+#endif
+
+
+#if LCD_USE_SCROLLING == 1
+/******************************************************************************
+ * Hardware scrolling: commands sent, lines moved into view are cleared and
+ * text is placed on the lines shown on the screen
+ */
+static int test_log_is(const uint16_t *expect, uint8_t n) {
+  if (lcd_host_log_length != n)
+    return 0;
+  for (uint8_t i = 0; i < n; i++)
+    if (lcd_host_log[i] != expect[i])
+      return 0;
+  return 1;
+  }
+
+static void test_text_block(uint16_t *pixels, uint16_t y) {
+  for (uint16_t i = 0; i < 8*48; i++)
+    pixels[i] = lcd_emu_ili9341_pixel(100 + i % 48, y + i / 48);
+  }
+
+static void test_scrolling(void) {
+  static const uint16_t define[] = {LCD_SCROLL_DEFINE, 0x100, 0x110, 0x101, 0x120,
+                                    0x100, 0x110, LCD_SCROLL_START, 0x100, 0x110};
+  static const uint16_t start[]  = {LCD_SCROLL_START, 0x100, 0x114};
+  color_t  a = {31, 0, 0}, b = {0, 63, 0};
+  uint16_t blue = lcd_pack_color((color_t){0, 0, 31});
+  uint16_t text[8*48], text_scrolled[8*48];
+  uint16_t x, y, bad = 0;
+
+  lcd_set_background(0, 0, 31);
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 31});
+  lcd_moveto_xy(5, 100);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("Scroll"));
+  lcd_font_flush();
+  test_text_block(text, 40);
+  for (x = 0; x < 8*48; x++)
+    if (text[x] != blue)
+      bad++;
+  test_check(bad > 0, "scrolling: reference text drawn");
+  bad = 0;
+
+  lcd_host_bus_reset();
+  lcd_scroll_define(16, 16);
+  test_check(test_log_is(define, sizeof(define)/sizeof(define[0])), "scrolling: VSCRDEF and VSCRSADD");
+
+  //memory rows 16..19 move to the bottom of the scroll area
+  lcd_fill_rect(0, 16, LCD_WIDTH, 4, b);
+  lcd_fill_rect(0, 20, LCD_WIDTH, 1, a);
+  lcd_host_bus_reset();
+  lcd_scroll(4);
+  test_check(lcd_host_log_length >= 3 && lcd_host_log[lcd_host_log_length-3] == start[0] &&
+             lcd_host_log[lcd_host_log_length-2] == start[1] &&
+             lcd_host_log[lcd_host_log_length-1] == start[2], "scrolling: VSCRSADD after lcd_scroll(4)");
+  test_check(lcd_emu_ili9341_pixel(0, 16) == lcd_pack_color(a) &&
+             lcd_emu_ili9341_pixel(LCD_WIDTH-1, 16) == lcd_pack_color(a), "scrolling: content moved up");
+  for (y = LCD_HEIGHT-20; y < LCD_HEIGHT-16; y++)
+    for (x = 0; x < LCD_WIDTH; x++)
+      if (lcd_emu_ili9341_pixel(x, y) != blue)
+        bad++;
+  test_check(!bad, "scrolling: exposed lines at the bottom cleared");
+  test_check(lcd_emu_ili9341_pixel(0, 15) == blue && lcd_emu_ili9341_pixel(0, LCD_HEIGHT-16) == blue,
+             "scrolling: fixed areas unchanged");
+
+  lcd_fill_rect(0, 16, LCD_WIDTH, 4, b);
+  lcd_scroll(-4);
+  for (bad = 0, y = 16; y < 20; y++)
+    for (x = 0; x < LCD_WIDTH; x++)
+      if (lcd_emu_ili9341_pixel(x, y) != blue)
+        bad++;
+  test_check(!bad && lcd_emu_ili9341_pixel(0, 20) == lcd_pack_color(a),
+             "scrolling: exposed lines at the top cleared");
+
+  //offset 280: screen row 40 is memory row 32
+  lcd_scroll(-8);
+  test_check(lcd_scroll_map_row(40) == 32, "scrolling: lcd_scroll_map_row wraps");
+  lcd_moveto_xy(5, 100);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("Scroll"));
+  lcd_font_flush();
+  test_text_block(text_scrolled, 40);
+  for (bad = 0, x = 0; x < 8*48; x++)
+    if (text[x] != text_scrolled[x])
+      bad++;
+  test_check(!bad, "scrolling: opaque text on the screen row");
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 31});
+  lcd_set_text_mode(LCD_TEXT_TRANSPARENT);
+  lcd_moveto_xy(5, 100);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("Scroll"));
+  lcd_font_flush();
+  lcd_set_text_mode(LCD_TEXT_OPAQUE);
+  test_text_block(text_scrolled, 40);
+  for (bad = 0, x = 0; x < 8*48; x++)
+    if (text[x] != text_scrolled[x])
+      bad++;
+  test_check(!bad, "scrolling: transparent text on the screen row");
+
+  lcd_set_rotation(LCD_ROTATE_90);
+  lcd_host_bus_reset();
+  lcd_scroll(4);
+  lcd_scroll_define(0, 0);
+  test_check(lcd_host_log_length == 0, "scrolling: ignored when rotated");
+  lcd_set_rotation(LCD_ROTATE_0);
+
+  lcd_scroll_define(0, 0);
+  lcd_set_background(0, 0, 0);
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 0, 0});
+  }
+#endif
+
+
+#if LCD_BAND_BPP > 0
+/******************************************************************************
+ * Band renderer: only changed bands are sent, indices are expanded through
+ * the palette, text is drawn into the bands
+ */
+static uint8_t test_band_changed;
+
+static void test_band_draw(uint16_t top, uint16_t bottom) {
+  lcd_band_fill_rect(10, 20, 30, 20, 2);   //bands 1 and 2
+  lcd_band_set_pixel(4, 5, 3);
+  lcd_band_set_pixel(5, 5, 15);
+  if (test_band_changed)
+    lcd_band_set_pixel(7, 50, 3);          //band 3
+  lcd_moveto_pixel(100, 12);               //bands 0 and 1
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("Band"));
+  }
+
+static uint8_t test_band_index(uint16_t x, uint16_t y) {
+  if (x == 4 && y == 5)                       return 3;
+  if (x == 5 && y == 5)                       return 15;
+  if (test_band_changed && x == 7 && y == 50) return 3;
+  if (x >= 10 && x < 40 && y >= 20 && y < 40) return 2;
+  return 0;
+  }
+
+static void test_band(void) {
+  color_t  palette[4] = {{0, 0, 0}, {31, 63, 31}, {31, 0, 0}, {0, 0, 31}};
+  uint16_t text[8*32];
+  uint16_t x, y, i, bad = 0;
+
+  lcd_set_foreground(31, 63, 31);
+  lcd_set_background(0, 0, 0);
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, palette[0]);
+  lcd_moveto_pixel(100, 12);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("Band"));
+  lcd_font_flush();
+  for (i = 0; i < 8*32; i++)
+    if ((text[i] = lcd_emu_ili9341_pixel(100 + i % 32, 12 + i / 32)))
+      bad++;
+  test_check(bad > 0, "band: reference text drawn");
+  bad = 0;
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, (color_t){0, 63, 0});
+
+  for (i = 0; i < 4; i++)
+    lcd_band_set_palette(i, palette[i]);
+  lcd_band_set_palette(15, (color_t){31, 63, 0});
+  lcd_band_set_text_color(1, 0);
+  lcd_host_bus_reset();
+  lcd_band_render(test_band_draw);
+  test_check(lcd_host_bus_count.bytes >= 2UL*LCD_WIDTH*LCD_HEIGHT, "band: first frame sends all bands");
+  for (y = 0; y < 48; y++)
+    for (x = 0; x < LCD_WIDTH; x++) {
+      if (x >= 100 && x < 132 && y >= 12 && y < 20)
+        continue;
+      i = test_band_index(x, y);
+      if (lcd_emu_ili9341_pixel(x, y) != lcd_pack_color(i == 15 ? (color_t){31, 63, 0} : palette[i]))
+        bad++;
+      }
+  test_check(!bad && lcd_emu_ili9341_pixel(LCD_WIDTH-1, LCD_HEIGHT-1) == 0,
+             "band: palette expanded to RGB565");
+  for (bad = 0, i = 0; i < 8*32; i++)
+    if (text[i] != lcd_emu_ili9341_pixel(100 + i % 32, 12 + i / 32))
+      bad++;
+  test_check(!bad, "band: text across two bands");
+
+  lcd_host_bus_reset();
+  lcd_band_render(test_band_draw);
+  test_check(lcd_host_bus_count.bytes == 0, "band: unchanged frame sends 0 bytes");
+
+  test_band_changed = 1;
+  lcd_host_bus_reset();
+  lcd_band_render(test_band_draw);
+  test_check(lcd_host_bus_count.bytes == 11 + 2UL*LCD_WIDTH*LCD_BAND_HEIGHT,
+             "band: one changed band sent");
+  test_check(lcd_emu_ili9341_pixel(7, 50) == lcd_pack_color(palette[3]), "band: changed pixel shown");
+  test_band_changed = 0;
+
+  lcd_band_set_palette(0, palette[1]);
+  lcd_host_bus_reset();
+  lcd_band_render(test_band_draw);
+  test_check(lcd_host_bus_count.bytes >= 2UL*LCD_WIDTH*LCD_HEIGHT &&
+             lcd_emu_ili9341_pixel(LCD_WIDTH-1, LCD_HEIGHT-1) == lcd_pack_color(palette[1]),
+             "band: palette change sends all bands");
+  lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, palette[0]);
+  }
+#endif
+
+
+int main(void) {
+  lcd_emu_ili9341_attach();
+  lcd_init();
+  test_wrap_rotated();
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+  test_image();
+#endif
+  test_primitives();
+  test_text_transparent();
+  test_plot_points();
+#if LCD_USE_READBACK == 1
+  test_readback();
+#endif
+#if LCD_USE_SCROLLING == 1
+  test_scrolling();
+#endif
+#if LCD_BAND_BPP > 0
+  test_band();
+#endif
+  printf(test_failed ? "FAILED\n" : "OK\n");
+  return test_failed;
+  }
@@ -0,0 +1,401 @@
+/******************************************************************************
+ * Host tests for dogm-graphic: draws into the emulated display and checks
+ * the bytes sent and the pixels shown. Built with all graphic functions,
+ * bitmaps, the shadow RAM and canvases (see Makefile), best with 
+ * -fsanitize=address.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "font.h"
+#include "lcd-host-bus.h"
+#include "lcd-emu.h"
+
+static int test_failed;
+
+static void test_check(int ok, const char *what) {
+  printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok)
+    test_failed = 1;
+  }
+
+
+/******************************************************************************
+ * A packed image reaching below the last page is cut, nothing is written
+ * beyond the display (or the shadow RAM) and the top pages are unchanged.
+ */
+//4 pages x 16 columns: runs, a literal and a run again
+static const uint8_t test_packed[] PROGMEM = {
+  LCD_IMAGE_PACKBITS,
+  0x8D, 0xFF,
+  0x0F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+        0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+  0x8D, 0x55,
+  0x8D, 0xAA,
+  };
+
+static void test_packed_clipped(void) {
+  int shown = 1, top = 1;
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  lcd_moveto_xy(LCD_RAM_PAGES - 2, 10);
+  lcd_host_bus_reset();
+  lcd_draw_image_packed_P(test_packed, 4, 16, NORMAL);
+  test_check(lcd_host_bus_count.bytes - lcd_host_bus_count.commands == 2*16,
+             "packed image: only visible pages sent");
+  for (int x = 10; x < 26; x++) {
+    shown &= lcd_emu_dog_pixel(x, 8*(LCD_RAM_PAGES-2)) != 0;     //run of 0xFF
+    for (int y = 0; y < 16; y++)
+      top &= lcd_emu_dog_pixel(x, y) == 0;
+    }
+  test_check(shown, "packed image: first page drawn");
+  test_check(top,   "packed image: no wrap to the top");
+  test_check(lcd_shadow_get(LCD_RAM_PAGES-1, 10) == 0x01, "packed image: shadow RAM updated");
+  }
+
+
+/******************************************************************************
+ * Text wrapping below the last page moves to the page after it, it is not
+ * taken modulo the page count and written over the top line
+ */
+static void test_wrap_bottom(void) {
+  int top = 1;
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  lcd_moveto_xy(LCD_RAM_PAGES - 1, LCD_WIDTH - 4);
+  lcd_put_string_P(FONT_FIXED_8, WRAP, PSTR("A"));
+  for (uint8_t x = 0; x < 8; x++)
+    top &= lcd_shadow_get(0, x) == 0;
+  test_check(top, "wrap: top line untouched in shadow RAM");
+  }
+
+
+/******************************************************************************
+ * lcd_transpose_8x8: bit b of dst[k] is bit k of src[b], also in place
+ */
+static void test_transpose(void) {
+  uint8_t src[8], dst[8], k, b;
+  int ok = 1;
+  for (uint16_t n = 0; n < 256; n++) {
+    for (k = 0; k < 8; k++)
+      src[k] = (uint8_t)(n * 37 + k * 101 + (n >> 3) * k);
+    lcd_transpose_8x8(src, dst);
+    for (k = 0; k < 8; k++)
+      for (b = 0; b < 8; b++)
+        ok &= ((dst[k] >> b) & 1) == ((src[b] >> k) & 1);
+    lcd_transpose_8x8(dst, dst);
+    for (k = 0; k < 8; k++)
+      ok &= dst[k] == src[k];
+    }
+  test_check(ok, "transpose: bits exchanged, twice is identity");
+  }
+
+
+/******************************************************************************
+ * lcd_rop: INVERT_BIT inverts the source and is not one of the operations,
+ * only bits in cover are changed
+ */
+static void test_rop(void) {
+  static const uint8_t rops[] = {LCD_ROP_COPY, LCD_ROP_OR, LCD_ROP_ANDNOT, LCD_ROP_XOR};
+  const uint8_t dst = 0xC5, src = 0x3A, cover = 0x7E;
+  int ok = (LCD_ROP_MASK & INVERT_BIT) == 0 && INVERT == INVERT_BIT;
+  for (uint8_t r = 0; r < 4; r++) {
+    ok &= lcd_rop(dst, src, cover, rops[r] | INVERT_BIT) == lcd_rop(dst, (uint8_t)~src, cover, rops[r]);
+    ok &= (lcd_rop(dst, src, cover, rops[r] | INVERT_BIT) & ~cover) == (dst & ~cover);
+    }
+  ok &= lcd_rop(dst, src, 0xFF, LCD_ROP_COPY | INVERT_BIT) == (uint8_t)~src;
+  ok &= lcd_rop(dst, src, 0xFF, LCD_ROP_XOR | INVERT_BIT) == (uint8_t)(dst ^ ~src);
+  test_check(ok, "rop: INVERT_BIT inverts the source, cover kept");
+  }
+
+#if LCD_USE_CANVAS == 1
+/******************************************************************************
+ * Canvas: output is redirected, the display cursor is kept, and blitting
+ * combines the canvas with the display by each raster operation
+ */
+static const uint8_t test_image[] PROGMEM = {
+  0x81, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x81,
+  0xFF, 0x00, 0xF0, 0x0F, 0xAA, 0x55, 0xCC, 0x33,
+  };
+
+static void test_canvas_draw(void) {
+  lcd_moveto_xy(0, 1);
+  lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR("Ab"));
+  lcd_moveto_xy(1, 20);
+  lcd_draw_image_P(test_image, 2, 8, INVERT);
+  lcd_clear_area_xy(1, 4, INVERT, 2, 2);
+  lcd_clear_area_xy(1, 2, NORMAL, 1, 21);
+  }
+
+static void test_canvas_redirect(void) {
+  static uint8_t buffer[3*32];
+  lcd_canvas_t canvas;
+  int same = 1;
+
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  lcd_canvas_init(&canvas, buffer, 32, 3);
+  lcd_moveto_xy(2, 30);
+  lcd_host_bus_reset();
+  lcd_set_target(&canvas);
+  test_canvas_draw();
+  test_check(lcd_host_bus_count.bytes == 0, "canvas: nothing sent to the display");
+  lcd_set_target(0);
+  test_check(lcd_get_position_page() == 2 && lcd_get_position_column() == 30,
+             "canvas: lcd_set_target(0) restores the cursor");
+  lcd_data(0x3C);
+  lcd_release();
+  test_check(lcd_shadow_get(2, 30) == 0x3C && lcd_emu_dog_pixel(30, 18) && !lcd_emu_dog_pixel(30, 17),
+             "canvas: next byte written at the display cursor");
+
+  //the same output on the display gives the same bytes
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  test_canvas_draw();
+  for (uint8_t p = 0; p < 3; p++)
+    for (uint8_t c = 0; c < 32; c++)
+      same &= buffer[p*32 + c] == lcd_shadow_get(p, c);
+  test_check(same && buffer[32 + 20] == 0x7E, "canvas: text, image and clearing redirected");
+  }
+
+static uint8_t test_blit_expect(uint8_t d, uint8_t s, uint8_t rop) {
+  if (rop & INVERT_BIT)
+    s = !s;
+  switch (rop & LCD_ROP_MASK) {
+    case LCD_ROP_OR:     return d | s;
+    case LCD_ROP_ANDNOT: return d & !s;
+    case LCD_ROP_XOR:    return d ^ s;
+    default:             return s;
+    }
+  }
+
+//Blits a 16 x 16 canvas to 5/y over a pattern, compares 40 x 40 pixels
+static int test_blit_rop(const lcd_canvas_t *canvas, uint8_t y, uint8_t rop) {
+  uint8_t before[40][40], s, d;
+  uint8_t x0 = 5, px, py;
+  for (uint8_t p = 0; p < 5; p++) {
+    lcd_moveto_xy(p, 0);
+    for (uint8_t c = 0; c < 40; c++)
+      lcd_data((uint8_t)(p * 37 + c * 11));
+    }
+  lcd_release();
+  for (py = 0; py < 40; py++)
+    for (px = 0; px < 40; px++)
+      before[py][px] = lcd_emu_dog_pixel(px, py) != 0;
+  lcd_canvas_blit(canvas, x0, y, rop);
+  for (py = 0; py < 40; py++)
+    for (px = 0; px < 40; px++) {
+      d = before[py][px];
+      if (px >= x0 && px < x0 + 16 && py >= y && py < y + 16) {
+        s = (canvas->data[((py - y) >> 3) * 16 + px - x0] >> ((py - y) & 7)) & 1;
+        d = test_blit_expect(d, s, rop);
+        }
+      if ((lcd_emu_dog_pixel(px, py) != 0) != d)
+        return 0;
+      }
+  return 1;
+  }
+
+static void test_canvas_blit(void) {
+  static const uint8_t rops[] = {LCD_ROP_COPY, LCD_ROP_OR, LCD_ROP_ANDNOT, LCD_ROP_XOR};
+  static uint8_t buffer[2*16], target_buffer[3*24];
+  static const char *names[] = {
+    "canvas: blit COPY, aligned and unaligned",   "canvas: blit OR, aligned and unaligned",
+    "canvas: blit ANDNOT, aligned and unaligned", "canvas: blit XOR, aligned and unaligned"};
+  lcd_canvas_t canvas, target;
+  int ok;
+
+  lcd_canvas_init(&canvas, buffer, 16, 2);
+  for (uint8_t i = 0; i < sizeof(buffer); i++)
+    buffer[i] = (uint8_t)(i * 29 + 3);
+  for (uint8_t r = 0; r < 4; r++) {
+    ok = 1;
+    for (uint8_t inv = 0; inv <= INVERT_BIT; inv += INVERT_BIT) {
+      ok &= test_blit_rop(&canvas, 8, rops[r] | inv);
+      ok &= test_blit_rop(&canvas, 11, rops[r] | inv);
+      }
+    test_check(ok, names[r]);
+    }
+
+  //aligned copies are sent as one block per page
+  lcd_host_bus_reset();
+  lcd_canvas_blit(&canvas, 5, 16, LCD_ROP_COPY);
+  test_check(lcd_host_bus_count.bytes - lcd_host_bus_count.commands == sizeof(buffer),
+             "canvas: aligned copy sends each byte once");
+
+  //into another canvas, clipped at its right and bottom edge
+  lcd_canvas_init(&target, target_buffer, 24, 3);
+  memset(target_buffer, 0x0F, sizeof(target_buffer));
+  lcd_set_target(&target);
+  lcd_canvas_blit(&canvas, 12, 12, LCD_ROP_XOR);
+  lcd_set_target(0);
+  ok = target_buffer[0*24 + 12] == 0x0F && target_buffer[2*24 + 11] == 0x0F;
+  for (uint8_t c = 0; c < 12; c++) {
+    ok &= target_buffer[1*24 + 12 + c] == (0x0F ^ (uint8_t)(buffer[c] << 4));
+    ok &= target_buffer[2*24 + 12 + c] == (0x0F ^ (uint8_t)((buffer[c] >> 4) | (buffer[16 + c] << 4)));
+    }
+  test_check(ok, "canvas: blit into a canvas, clipped");
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  }
+#endif
+
+
+#if LCD_INCLUDE_BITMAP_FUNCTIONS == 1
+/******************************************************************************
+ * Row-major bitmaps: bit order, inversion, heights not a multiple of 8 and
+ * streams, which are read completely even if clipped
+ */
+static uint32_t test_stream_pos;
+
+static uint8_t test_stream_byte(uint32_t pos) {
+  return (uint8_t)(pos * 13 + 5) ^ (uint8_t)(pos >> 4);
+  }
+
+static uint8_t test_stream_read(uint8_t *buffer, uint8_t count) {
+  while (count--)
+    *buffer++ = test_stream_byte(test_stream_pos++);
+  return 1;
+  }
+
+//Pixel x/y of a bitmap, also for streams (data 0)
+static uint8_t test_bitmap_bit(const uint8_t *data, uint8_t width, uint16_t x, uint16_t y, uint8_t style) {
+  uint16_t i = y * ((width + 7) / 8) + x / 8;
+  uint8_t  b = data ? data[i] : test_stream_byte(i);
+  return ((style & LCD_BITMAP_LSB_FIRST) ? b >> (x & 7) : b >> (7 - (x & 7))) & 1;
+  }
+
+//Bitmap at page/column over a set background, compares 24 rows below the page
+static int test_bitmap_shown(const uint8_t *data, uint8_t width, uint8_t height, 
+                             uint8_t page, uint8_t column, uint8_t style) {
+  uint8_t v;
+  for (uint16_t y = 8*page; y < 8*page + 24 && y < 8*LCD_RAM_PAGES; y++)
+    for (uint16_t x = column; x < LCD_WIDTH; x++) {
+      v = 1;
+      if (x - column < width && y - 8*page < height)
+        v = test_bitmap_bit(data, width, x - column, y - 8*page, style) ^ ((style & INVERT_BIT) ? 1 : 0);
+      if ((lcd_emu_dog_pixel(x, y) != 0) != v)
+        return 0;
+      }
+  return 1;
+  }
+
+static void test_bitmap(void) {
+  static uint8_t bitmap[2*11];
+  const uint8_t page = 1, column = 3;
+  int ok = 1;
+
+  for (uint8_t i = 0; i < sizeof(bitmap); i++)
+    bitmap[i] = (uint8_t)(i * 41 + 7);
+  //12 x 11 pixels: the second page has 3 rows, the rows below are kept
+  for (uint8_t style = 0; style < 4; style++) {
+    uint8_t s = ((style & 1) ? LCD_BITMAP_LSB_FIRST : LCD_BITMAP_MSB_FIRST) | ((style & 2) ? INVERT_BIT : 0);
+    lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, INVERT, 0, 0);
+    lcd_moveto_xy(page, column);
+    lcd_draw_bitmap(bitmap, 12, 11, s);
+    ok &= test_bitmap_shown(bitmap, 12, 11, page, column, s);
+    if (style == 0)
+      test_check(ok, "bitmap: MSB first, 11 rows");
+    if (style == 1)
+      test_check(ok, "bitmap: LSB first");
+    }
+  test_check(ok, "bitmap: inverted, lines below kept");
+
+  //clipped at the right edge and below the last page, all rows are read
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, INVERT, 0, 0);
+  lcd_moveto_xy(LCD_RAM_PAGES - 1, LCD_WIDTH - 20);
+  test_stream_pos = 0;
+  ok  = lcd_draw_bitmap_stream(test_stream_read, 100, 21, LCD_BITMAP_MSB_FIRST);
+  ok &= test_stream_pos == 13UL * 21;
+  test_check(ok, "bitmap stream: clipped rows and columns are read");
+  test_check(test_bitmap_shown(0, 100, 21, LCD_RAM_PAGES - 1, LCD_WIDTH - 20, LCD_BITMAP_MSB_FIRST),
+             "bitmap stream: visible part drawn");
+
+  //wider than the display: the strip holds LCD_STRIP_BYTES per row
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, INVERT, 0, 0);
+  lcd_moveto_xy(0, 0);
+  test_stream_pos = 0;
+  ok  = lcd_draw_bitmap_stream(test_stream_read, 255, 16, LCD_BITMAP_LSB_FIRST | INVERT_BIT);
+  ok &= test_stream_pos == 32UL * 16;
+  test_check(ok && test_bitmap_shown(0, 255, 16, 0, 0, LCD_BITMAP_LSB_FIRST | INVERT_BIT),
+             "bitmap stream: full width, strip bound");
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  }
+#endif
+
+
+#if LCD_ROTATION == 90 || LCD_ROTATION == 270
+/******************************************************************************
+ * lcd_canvas_flush_rotated: the view is shown turned by LCD_ROTATION, sent
+ * as a whole or in bands of 16 columns
+ */
+static uint8_t test_view[LCD_VIEW_PAGES * LCD_VIEW_WIDTH];
+static uint8_t test_view_band[LCD_VIEW_PAGES * 16];
+
+static uint8_t test_view_pixel(uint16_t x, uint16_t y) {
+  return (test_view[(y >> 3) * LCD_VIEW_WIDTH + x] >> (y & 7)) & 1;
+  }
+
+static int test_rotated_shown(void) {
+  uint8_t v;
+  for (uint16_t y = 0; y < LCD_HEIGHT; y++)
+    for (uint16_t x = 0; x < LCD_WIDTH; x++) {
+  #if LCD_ROTATION == 90
+      v = test_view_pixel(LCD_HEIGHT - 1 - y, x);
+  #else
+      v = test_view_pixel(y, LCD_WIDTH - 1 - x);
+  #endif
+      if ((lcd_emu_dog_pixel(x, y) != 0) != v)
+        return 0;
+      }
+  return 1;
+  }
+
+static void test_rotated(void) {
+  lcd_canvas_t view, band;
+  uint16_t i;
+  for (i = 0; i < sizeof(test_view); i++)
+    test_view[i] = (uint8_t)(i * 73 + (i >> 5) * 11);
+  lcd_canvas_init(&view, test_view, LCD_VIEW_WIDTH, LCD_VIEW_PAGES);
+  lcd_set_target(&view);
+  lcd_moveto_xy(0, 0);
+  lcd_put_string_P(FONT_PROP_8, NORMAL|WRAP, PSTR("Portrait text wraps here"));
+  lcd_set_target(0);
+
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  lcd_host_bus_reset();
+  lcd_canvas_flush_rotated(&view, 0);
+  test_check(lcd_host_bus_count.bytes - lcd_host_bus_count.commands == 
+             (uint32_t)LCD_WIDTH * LCD_HEIGHT / 8, "rotated: one byte per 8 pixels");
+  test_check(test_rotated_shown(), "rotated: whole view shown turned");
+
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  lcd_canvas_init(&band, test_view_band, 16, LCD_VIEW_PAGES);
+  for (uint8_t x = 0; x < LCD_VIEW_WIDTH; x += 16) {
+    for (uint8_t p = 0; p < LCD_VIEW_PAGES; p++)
+      memcpy(test_view_band + 16*p, test_view + p*LCD_VIEW_WIDTH + x, 16);
+    lcd_canvas_flush_rotated(&band, x);
+    }
+  test_check(test_rotated_shown(), "rotated: bands of 16 columns shown turned");
+  lcd_clear_area_xy(LCD_RAM_PAGES, LCD_WIDTH, NORMAL, 0, 0);
+  }
+#endif
+
+
+int main(void) {
+  lcd_emu_dog_attach();
+  lcd_init();
+  test_packed_clipped();
+  test_wrap_bottom();
+  test_transpose();
+  test_rop();
+#if LCD_USE_CANVAS == 1
+  test_canvas_redirect();
+  test_canvas_blit();
+#endif
+#if LCD_INCLUDE_BITMAP_FUNCTIONS == 1
+  test_bitmap();
+#endif
+#if LCD_ROTATION == 90 || LCD_ROTATION == 270
+  test_rotated();
+#endif
+  printf(test_failed ? "FAILED\n" : "OK\n");
+  return test_failed;
+  }
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Host test for dogm-graphic.hpp: the same operations through the C library
+ * and through the template for the same display type and orientation give
+ * the same bytes, DC levels and chip selects on the bus. Built once per
+ * DISPLAY_TYPE and ORIENTATION_UPSIDEDOWN (see Makefile).
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "lcd-host-hpp.h"
+
+uint8_t HostA0::level;
+
+static int test_failed;
+
+//Log of the C library, compared with the template
+static uint16_t test_log[LCD_HOST_LOG_SIZE];
+static uint32_t test_length, test_selects;
+
+static void test_c_done(void) {
+  test_length  = lcd_host_log_length;
+  memcpy(test_log, lcd_host_log, test_length * sizeof(test_log[0]));
+  test_selects = lcd_host_bus_count.selects;
+  lcd_host_bus_reset();
+  }
+
+static void test_hpp_done(const char *what) {
+  int ok = test_length == lcd_host_log_length && test_selects == lcd_host_bus_count.selects
+        && !memcmp(test_log, lcd_host_log, test_length * sizeof(test_log[0]));
+  printf("%3d/%d %-44s %s\n", DISPLAY_TYPE, ORIENTATION_UPSIDEDOWN, what, ok ? "ok" : "FAILED");
+  if (!ok)
+    test_failed = 1;
+  lcd_host_bus_reset();
+  }
+
+
+//2 pages x 16 columns
+static const uint8_t test_image[32] PROGMEM = {
+  0x00, 0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x00, 0x3C, 0x42, 0x81, 0x81, 0x42, 0x3C,
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0xAA, 0x55, 0xAA, 0x55, 0x00, 0x00, 0xF0, 0x0F,
+  };
+
+
+int main(void) {
+  lcd_host_bus_reset();
+  lcd_init();
+  test_c_done();
+  Hpp::init();
+  test_hpp_done("init");
+
+  lcd_moveto_xy(1, 10);
+  lcd_draw_image_P(test_image, 2, 16, NORMAL);
+  test_c_done();
+  Hpp::moveto_xy(1, 10);
+  Hpp::draw_image_P(test_image, 2, 16, dogm::normal);
+  test_hpp_done("draw_image_P");
+
+  lcd_moveto_xy(2, 0);
+  lcd_draw_image_P(test_image, 2, 16, INVERT);
+  test_c_done();
+  Hpp::moveto_xy(2, 0);
+  Hpp::draw_image_P(test_image, 2, 16, dogm::invert);
+  test_hpp_done("draw_image_P, inverted");
+
+  lcd_clear_area_xy(2, 20, NORMAL, 1, 5);
+  test_c_done();
+  Hpp::clear_area_xy(2, 20, dogm::normal, 1, 5);
+  test_hpp_done("clear_area_xy");
+
+  lcd_clear_area_xy(3, LCD_WIDTH, INVERT, LCD_RAM_PAGES - 3, 0);
+  test_c_done();
+  Hpp::clear_area_xy(3, Hpp::width, dogm::invert, Hpp::pages - 3, 0);
+  test_hpp_done("clear_area_xy, last pages inverted");
+
+  lcd_moveto_xy(0, 0);
+  lcd_data(0x5A);
+  lcd_data(0xA5);
+  lcd_command(LCD_NO_OP);
+  lcd_release();
+  test_c_done();
+  Hpp::moveto_xy(0, 0);
+  Hpp::data(0x5A);
+  Hpp::data(0xA5);
+  Hpp::command(LCD_NO_OP);
+  Hpp::release();
+  test_hpp_done("data, command");
+
+#if DISPLAY_TYPE == 240
+  lcd_set_contrast(60);
+  test_c_done();
+  Hpp::set_contrast(60);
+  test_hpp_done("set_contrast");
+#endif
+
+  printf(test_failed ? "FAILED\n" : "OK\n");
+  return test_failed;
+  }
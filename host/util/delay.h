@@ -0,0 +1,10 @@
+/******************************************************************************
+ * Host stub for <util/delay.h>: delays are skipped
+ *****************************************************************************/
+#ifndef HOST_UTIL_DELAY_H_INCLUDED
+#define HOST_UTIL_DELAY_H_INCLUDED
+
+#define _delay_ms(ms)  ((void)0)
+#define _delay_us(us)  ((void)0)
+
+#endif
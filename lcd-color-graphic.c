@@ -1,6 +1,26 @@
 /******************************************************************************
  * Display Library
  * for an LCD with ILI9341 driver in 16 Bit color mode using 4-wire SPI
+ * New features in v0.02
+ *   - font bytes are collected and written in one address window per row
+ *     of a glyph (or per run of glyphs for 8 pixel fonts)
+ *   - packed colors are stored when setting foreground and background
+ *   - added lcd_fill_rect and lcd_send_pixels for fast filling of areas
+ *   - added band renderer with indexed colors (LCD_BAND_BPP)
+ *   - added lcd_draw_image_xy_P for raw and compressed images
+ *   - added lines, rectangles and circles, drawn as horizontal and vertical 
+ *     spans with one address window each
+ *   - text with transparent background (lcd_set_text_mode)
+ *   - opaque text is streamed with exchanged rows and columns
+ *   - screen rotation by 0, 90, 180 or 270 degrees (lcd_set_rotation)
+ *   - hardware vertical scrolling (LCD_USE_SCROLLING)
+ *   - blending with display content read back from the display memory
+ *   - text can be placed at any pixel line (lcd_moveto_pixel)
+ *   - lcd_plot_points plots many points, merged into runs
+ *   - bus to the display is selected in lcd-transport.h
+ *   - optional counters for diagnostics (LCD_USE_STATS)
+ *   - optional timing of rendering functions (LCD_USE_TIMING)
+ *   - lcd_transpose_8x8 of lcd-transpose.h used for vertical text
  * New features in v0.01
  *   - well... everything.
  *****************************************************************************/
@@ -8,6 +28,67 @@
 #include "lcd-color-graphic.h"
 
 
+#if LCD_USE_STATS
+//=============================================================================
+//Counters for diagnostics, see lcd-stats.h
+//=============================================================================
+lcd_stats_t lcd_stats;
+
+/******************************************************************************
+ * Copies the counters
+ * s             - destination
+ */
+void lcd_stats_snapshot(lcd_stats_t *s) {
+  memcpy(s, &lcd_stats, sizeof(lcd_stats_t));
+  }
+
+/******************************************************************************
+ * Sets all counters to 0
+ */
+void lcd_stats_reset(void) {
+  memset(&lcd_stats, 0, sizeof(lcd_stats_t));
+  }
+#endif
+
+#if LCD_USE_TIMING
+//=============================================================================
+//Timing of rendering functions, see lcd-stats.h
+//=============================================================================
+lcd_timing_t lcd_timing[LCD_SPAN_COUNT];
+
+/******************************************************************************
+ * Adds a span to the timing table
+ * span          - group of functions, LCD_SPAN_*
+ * start         - LCD_TIMER() at the begin of the span
+ */
+void lcd_timing_record(uint8_t span, lcd_ticks_t start) {
+  lcd_ticks_t   t = (lcd_ticks_t)(LCD_TIMER() - start);
+  lcd_timing_t *s = &lcd_timing[span];
+  if (!s->count || t < s->min)
+    s->min = t;
+  if (t > s->max)
+    s->max = t;
+  s->sum += t;
+  s->count++;
+  }
+
+/******************************************************************************
+ * Copies the timing table
+ * t             - destination, LCD_SPAN_COUNT entries
+ */
+void lcd_timing_snapshot(lcd_timing_t *t) {
+  memcpy(t, lcd_timing, sizeof(lcd_timing));
+  }
+
+/******************************************************************************
+ * Clears the timing table
+ */
+void lcd_timing_reset(void) {
+  memset(lcd_timing, 0, sizeof(lcd_timing));
+  }
+#endif
+
+
 /******************************************************************************
   * Global variables for color handling
   * Foreground is the normal drawing color
@@ -16,6 +97,17 @@
 
 color_t foreground = {.red=0x1F, .green=0x3F, .blue=0x1F};
 color_t background = {.red=0,    .green=0,    .blue=0};
+uint16_t foreground_packed = 0xFFFF;
+uint16_t background_packed = 0x0000;
+
+
+/******************************************************************************
+  * Screen geometry, depending on rotation
+  * lcd_madctl holds the memory access control setting (LCD_MIRROR)
+  */
+uint16_t lcd_width  = LCD_WIDTH;
+uint16_t lcd_height = LCD_HEIGHT;
+uint8_t  lcd_madctl = LCD_MADCTL_FLAGS;
 
 
 /******************************************************************************
@@ -24,7 +116,7 @@ color_t background = {.red=0,    .green=0,    .blue=0};
 void lcd_init() {
   LCD_SET_PIN_DIRECTIONS();  //set outputs
   _delay_ms(1);
-  LCD_INIT_SPI();            //Initialize SPI Interface  
+  LCD_BUS_INIT();            //Initialize SPI Interface  
   _delay_ms(50);
   LCD_RESET_ON();            //Apply Reset to the Display Controller  
   _delay_ms(100); 
@@ -33,17 +125,38 @@ void lcd_init() {
   LCD_SELECT();               //Switches chip select on
   lcd_command(LCD_SLEEP_OUT); //Wake up LCD
   _delay_ms(70);
+  lcd_command_1(LCD_MIRROR, lcd_madctl);
   return;
   }
 
+
+/******************************************************************************
+  * Rotates the screen. Rows and columns are exchanged by the display 
+  * controller, so there is no cost when drawing.
+  * rotation      - one of LCD_ROTATE_0, _90, _180, _270
+  */
+void lcd_set_rotation(uint8_t rotation) {
+  static const uint8_t madctl[4] = {0, LCD_FLIP_XY | LCD_MIRROR_X, 
+                                    LCD_MIRROR_X | LCD_MIRROR_Y, LCD_FLIP_XY | LCD_MIRROR_Y};
+  lcd_font_flush();
+  lcd_madctl = madctl[rotation & 3] | LCD_MADCTL_FLAGS;
+  lcd_width  = (rotation & 1) ? LCD_HEIGHT : LCD_WIDTH;
+  lcd_height = (rotation & 1) ? LCD_WIDTH  : LCD_HEIGHT;
+  lcd_command_1(LCD_MIRROR, lcd_madctl);
+#if LCD_BAND_BPP > 0
+  lcd_band_invalidate();
+#endif
+  }
+
   
 /******************************************************************************
   * Sends a command to the display
   */
 inline void lcd_command(uint8_t c) {
-  spi_wait_for_idle();
+  LCD_STAT_INC(commands);
+  lcd_bus_wait();
   LCD_CMD();
-  spi_write(c);
+  lcd_bus_write(c);
   }
 
 /******************************************************************************
@@ -58,9 +171,9 @@ inline void lcd_command_1(uint8_t c, uint8_t data) {
   * Sends a data word to the display
   */
 inline void lcd_data(uint8_t c) {
-  spi_wait_for_idle();
+  lcd_bus_wait();
   LCD_DATA();
-  spi_write(c);
+  lcd_bus_write(c);
 }  
 
 
@@ -69,9 +182,11 @@ inline void lcd_data(uint8_t c) {
   * Stores the main drawing color for later use
   */
 inline void lcd_set_foreground(uint8_t r, uint8_t g, uint8_t b) {
+  lcd_font_flush();
   foreground.red = r;
   foreground.green = g;
   foreground.blue = b;
+  foreground_packed = lcd_pack_color(foreground);
   }
 
 
@@ -79,9 +194,11 @@ inline void lcd_set_foreground(uint8_t r, uint8_t g, uint8_t b) {
   * Stores the background color for later use
   */
 inline void lcd_set_background(uint8_t r, uint8_t g, uint8_t b) {
+  lcd_font_flush();
   background.red = r;
   background.green = g;
   background.blue = b;
+  background_packed = lcd_pack_color(background);
   }
 
 
@@ -89,6 +206,7 @@ inline void lcd_set_background(uint8_t r, uint8_t g, uint8_t b) {
   * Sets the column range used for the next write operation
   */
 inline void lcd_set_column(uint16_t start, uint16_t end) {
+  LCD_STAT_INC(address_sets);
   lcd_command(LCD_SET_COLUMN);
   lcd_data(start >> 8);
   lcd_data(start);
@@ -100,6 +218,7 @@ inline void lcd_set_column(uint16_t start, uint16_t end) {
   * Sets the page range used for the next write operation
   */
 inline void lcd_set_page(uint16_t start, uint16_t end) {
+  LCD_STAT_INC(address_sets);
   lcd_command(LCD_SET_PAGE);
   lcd_data(start >> 8);
   lcd_data(start);
@@ -114,11 +233,52 @@ inline void lcd_send_pixel(color_t c) {
   lcd_data((c.red<<3) | (c.green>>3));
   lcd_data((c.green<<5) | c.blue);
   }  
+
+/******************************************************************************
+  * Writes a packed pixel, data mode must already be selected
+  */
+static inline void lcd_send_packed(uint16_t c) {
+  lcd_bus_write(c >> 8);
+  lcd_bus_write(c);
+  }
+
+/******************************************************************************
+  * Starts writing to display memory and selects data mode for the pixels
+  */
+static inline void lcd_write_mem_start(void) {
+  lcd_command(LCD_WRITE_MEM);
+  lcd_bus_wait();
+  LCD_DATA();
+  }
   
+  
+/******************************************************************************
+  * Writes the same packed pixel several times. Display must be in write mode.
+  * c             - packed color, see lcd_pack_color
+  * count         - number of pixels
+  */
+void lcd_send_pixels(uint16_t c, uint32_t count) {
+  lcd_bus_wait();
+  LCD_DATA();
+  lcd_bus_write_repeat(c >> 8, c, count);
+  }
+
+/******************************************************************************
+  * Sets the address window and starts writing to display memory
+  * col0, col1    - left and right edge of the window
+  * page0, page1  - top and bottom edge of the window
+  */
+void lcd_set_window(uint16_t col0, uint16_t col1, uint16_t page0, uint16_t page1) {
+  lcd_set_column(col0,col1);
+  lcd_set_page(page0,page1);
+  lcd_write_mem_start();
+  }
+
 /******************************************************************************
   * Sets a pixel at a given position
   */
 inline void lcd_set_pixel_xy(uint16_t column, uint16_t page) {
+  lcd_font_flush();
   lcd_set_page(page,page);
   lcd_set_column(column,column);
   lcd_command(LCD_WRITE_MEM);
@@ -135,38 +295,845 @@ inline void lcd_set_pixel_xy(uint16_t column, uint16_t page) {
  * r,g,b         - the color to be used
  */
 void lcd_set_area_xy(uint16_t col0, uint16_t col1, uint16_t page0, uint16_t page1) {
-  lcd_set_column(col0,col1);
-  lcd_set_page(page0,page1);
-  lcd_command(LCD_WRITE_MEM);
-  for(uint16_t y = page0; y <= page1; y++)
-    for(uint16_t x = col0; x <= col1; x++) {
-      lcd_send_pixel(background);
+  LCD_SPAN_BEGIN();
+  lcd_font_flush();
+  lcd_set_window(col0,col1,page0,page1);
+  lcd_send_pixels(background_packed, (uint32_t)(col1-col0+1) * (page1-page0+1));
+  LCD_SPAN_END(LCD_SPAN_CLEAR);
+  }
+
+
+/******************************************************************************
+ * This function fills a rectangle with a given color
+ * x, y          - upper left corner of the rectangle
+ * w, h          - width and height of the rectangle
+ * c             - the color to be used
+ */
+void lcd_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, color_t c) {
+  if (x >= lcd_width || y >= lcd_height || !w || !h)
+    return;
+  LCD_SPAN_BEGIN();
+  if (w > lcd_width - x)
+    w = lcd_width - x;
+  if (h > lcd_height - y)
+    h = lcd_height - y;
+  lcd_font_flush();
+  lcd_set_window(x,x+w-1,y,y+h-1);
+  lcd_send_pixels(lcd_pack_color(c), (uint32_t)w * h);
+  LCD_SPAN_END(LCD_SPAN_CLEAR);
+  }
+  
+  
+  
+//=============================================================================
+//Drawing functions
+// All shapes are split into horizontal and vertical spans, each span is 
+// written with one address window and a run of pixels.
+//=============================================================================
+
+/******************************************************************************
+ * Fills a rectangle with the foreground color, clipped to the screen
+ * x, y          - upper left corner
+ * w, h          - width and height
+ */
+static void lcd_span(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (w <= 0 || h <= 0 || x >= lcd_width || y >= lcd_height)
+    return;
+  if (w > lcd_width - x)
+    w = lcd_width - x;
+  if (h > lcd_height - y)
+    h = lcd_height - y;
+  lcd_font_flush();
+  lcd_set_window(x,x+w-1,y,y+h-1);
+  lcd_send_pixels(foreground_packed, (uint32_t)w * h);
+  }
+
+
+/******************************************************************************
+ * Draws a horizontal line
+ * x, y          - left end of the line
+ * w             - length of the line
+ */
+void lcd_draw_hline(int16_t x, int16_t y, int16_t w) {
+  lcd_span(x,y,w,1);
+  }
+
+
+/******************************************************************************
+ * Draws a vertical line
+ * x, y          - upper end of the line
+ * h             - length of the line
+ */
+void lcd_draw_vline(int16_t x, int16_t y, int16_t h) {
+  lcd_span(x,y,1,h);
+  }
+
+
+/******************************************************************************
+ * Draws a span between two points on the same row or column
+ */
+static void lcd_line_run(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  if (x1 < x0) { int16_t t = x0; x0 = x1; x1 = t; }
+  if (y1 < y0) { int16_t t = y0; y0 = y1; y1 = t; }
+  lcd_span(x0, y0, x1-x0+1, y1-y0+1);
+  }
+
+
+/******************************************************************************
+ * Draws a line between two points. The points calculated with Bresenham's 
+ * algorithm are collected into horizontal runs (for flat lines) or vertical 
+ * runs (for steep lines).
+ * x0, y0        - start point
+ * x1, y1        - end point
+ */
+void lcd_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  int16_t dx    = (x1 > x0) ? x1 - x0 : x0 - x1;
+  int16_t dy    = (y1 > y0) ? y0 - y1 : y1 - y0;
+  int8_t  sx    = (x0 < x1) ? 1 : -1;
+  int8_t  sy    = (y0 < y1) ? 1 : -1;
+  uint8_t steep = -dy > dx;
+  int16_t err   = dx + dy;
+  int16_t rx    = x0, ry = y0;  //start of current run
+  int16_t px, py;               //last point
+  
+  int16_t e2;
+  
+  for (;;) {
+    px = x0; py = y0;
+    if (x0 == x1 && y0 == y1)
+      break;
+    e2 = 2*err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+    if (steep ? (x0 != px) : (y0 != py)) {
+      lcd_line_run(rx, ry, px, py);
+      rx = x0; ry = y0;
       }
+    }
+  lcd_line_run(rx, ry, x1, y1);
   }
+
+
+/******************************************************************************
+ * Plots a set of points. The points are sorted by row and column (in place),
+ * then adjacent points on a row are merged into runs. Each run needs one 
+ * column window, the page window is only sent when the row changes.
+ * points        - array of points, reordered by this function
+ * count         - number of points
+ */
+void lcd_plot_points(lcd_point_t *points, uint16_t count) {
+  uint16_t    gap, i, j, n;
+  int16_t     row = -1;
+  lcd_point_t p;
   
+  //Shell sort, rows first
+  for (gap = count/2; gap; gap /= 2) {
+    for (i = gap; i < count; i++) {
+      p = points[i];
+      for (j = i; j >= gap && (points[j-gap].y > p.y || 
+          (points[j-gap].y == p.y && points[j-gap].x > p.x)); j -= gap)
+        points[j] = points[j-gap];
+      points[j] = p;
+      }
+    }
+  lcd_font_flush();
+  for (i = 0; i < count; i += n) {
+    p = points[i];
+    //merge adjacent points, duplicates are skipped
+    for (n = 1; i+n < count && points[i+n].y == p.y && 
+                points[i+n].x - points[i+n-1].x <= 1; n++);
+    if (p.y < 0 || p.y >= (int16_t)lcd_height)
+      continue;
+    //clip the run at both edges
+    int16_t x0 = p.x < 0 ? 0 : p.x;
+    int16_t x1 = points[i+n-1].x;
+    if (x1 >= (int16_t)lcd_width)
+      x1 = lcd_width-1;
+    if (x0 > x1)
+      continue;
+    lcd_set_column(x0,x1);
+    if (p.y != row) {
+      row = p.y;
+      lcd_set_page(row,row);
+      }
+    lcd_write_mem_start();
+    lcd_send_pixels(foreground_packed, x1-x0+1);
+    }
+  }
+
+
+/******************************************************************************
+ * Draws the outline of a rectangle
+ * x, y          - upper left corner
+ * w, h          - width and height
+ */
+void lcd_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (w <= 0 || h <= 0)
+    return;
+  lcd_span(x, y,     w, 1);
+  lcd_span(x, y+h-1, w, 1);
+  lcd_span(x,     y+1, 1, h-2);
+  lcd_span(x+w-1, y+1, 1, h-2);
+  }
+
+
+/******************************************************************************
+ * Draws the outline of four quarter circles with radius r around the centers
+ * (cx0,cy0), (cx1,cy0), (cx0,cy1) and (cx1,cy1), connected by straight lines.
+ * Points of the midpoint algorithm with the same y (or x, for the steep 
+ * octants) are collected into one span.
+ */
+static void lcd_draw_arcs(int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1, int16_t r) {
+  int16_t x = 0, y = r, f = 1 - r;
+  int16_t xs = 0, yo;
+  while (x <= y) {
+    yo = y;
+    if (f < 0) {
+      f += 2*x + 3;
+      }
+    else {
+      f += 2*(x - y) + 5;
+      y--;
+      }
+    x++;
+    if (y == yo && x <= y)
+      continue;
+    //points xs ... x-1 on row yo are done
+    if (xs == 0) {
+      lcd_span(cx0-(x-1), cy0-yo, cx1-cx0+2*x-1, 1);
+      lcd_span(cx0-(x-1), cy1+yo, cx1-cx0+2*x-1, 1);
+      lcd_span(cx0-yo, cy0-(x-1), 1, cy1-cy0+2*x-1);
+      lcd_span(cx1+yo, cy0-(x-1), 1, cy1-cy0+2*x-1);
+      }
+    else {
+      lcd_span(cx0-(x-1), cy0-yo, x-xs, 1);
+      lcd_span(cx1+xs,    cy0-yo, x-xs, 1);
+      lcd_span(cx0-(x-1), cy1+yo, x-xs, 1);
+      lcd_span(cx1+xs,    cy1+yo, x-xs, 1);
+      lcd_span(cx0-yo, cy0-(x-1), 1, x-xs);
+      lcd_span(cx0-yo, cy1+xs,    1, x-xs);
+      lcd_span(cx1+yo, cy0-(x-1), 1, x-xs);
+      lcd_span(cx1+yo, cy1+xs,    1, x-xs);
+      }
+    xs = x;
+    }
+  }
+
+
+/******************************************************************************
+ * Fills four quarter circles with radius r around the centers (cx0,cy0), 
+ * (cx1,cy0), (cx0,cy1) and (cx1,cy1) and the area between them, one 
+ * horizontal span per row.
+ */
+static void lcd_fill_arcs(int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1, int16_t r) {
+  int32_t limit = (int32_t)r*r + r;
+  int16_t x = r;
+  lcd_span(cx0-r, cy0, cx1-cx0+2*r+1, cy1-cy0+1);
+  for (int16_t dy = 1; dy <= r; dy++) {
+    while ((int32_t)x*x + (int32_t)dy*dy > limit)
+      x--;
+    lcd_span(cx0-x, cy0-dy, cx1-cx0+2*x+1, 1);
+    lcd_span(cx0-x, cy1+dy, cx1-cx0+2*x+1, 1);
+    }
+  }
+
+
+/******************************************************************************
+ * Draws the outline of a rectangle with rounded corners
+ * x, y          - upper left corner
+ * w, h          - width and height
+ * r             - radius of the corners
+ */
+void lcd_draw_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r) {
+  if (w <= 0 || h <= 0)
+    return;
+  if (r > (w-1)/2) r = (w-1)/2;
+  if (r > (h-1)/2) r = (h-1)/2;
+  lcd_draw_arcs(x+r, y+r, x+w-1-r, y+h-1-r, r);
+  }
+
+
+/******************************************************************************
+ * Draws a filled rectangle with rounded corners
+ * x, y          - upper left corner
+ * w, h          - width and height
+ * r             - radius of the corners
+ */
+void lcd_fill_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r) {
+  if (w <= 0 || h <= 0)
+    return;
+  if (r > (w-1)/2) r = (w-1)/2;
+  if (r > (h-1)/2) r = (h-1)/2;
+  lcd_fill_arcs(x+r, y+r, x+w-1-r, y+h-1-r, r);
+  }
+
+
+/******************************************************************************
+ * Draws the outline of a circle
+ * cx, cy        - center of the circle
+ * r             - radius
+ */
+void lcd_draw_circle(int16_t cx, int16_t cy, int16_t r) {
+  lcd_draw_arcs(cx, cy, cx, cy, r);
+  }
+
+
+/******************************************************************************
+ * Draws a filled circle
+ * cx, cy        - center of the circle
+ * r             - radius
+ */
+void lcd_fill_circle(int16_t cx, int16_t cy, int16_t r) {
+  lcd_fill_arcs(cx, cy, cx, cy, r);
+  }
+
+
+//=============================================================================
+//Hardware vertical scrolling
+// The display shows the scroll area starting at memory row 
+// lcd_scroll_top + lcd_scroll_offset, wrapping around at its end.
+//=============================================================================
+#if LCD_USE_SCROLLING == 1
+
+uint16_t lcd_scroll_top    = 0;  //height of top fixed area
+uint16_t lcd_scroll_height = 0;  //height of scroll area, 0 if not defined
+uint16_t lcd_scroll_offset = 0;  //first memory row shown in scroll area
+
+/******************************************************************************
+ * Sends a 16 bit argument
+ */
+static void lcd_data_16(uint16_t d) {
+  lcd_data(d >> 8);
+  lcd_data(d);
+  }
+
+/******************************************************************************
+ * Defines the scroll area and resets the scroll position
+ * top_fixed     - number of lines at the top not scrolled
+ * bottom_fixed  - number of lines at the bottom not scrolled
+ */
+void lcd_scroll_define(uint16_t top_fixed, uint16_t bottom_fixed) {
+  if (lcd_madctl != LCD_MADCTL_FLAGS)
+    return;   //rotation 0 only
+  lcd_font_flush();
+  lcd_scroll_top    = top_fixed;
+  lcd_scroll_height = LCD_HEIGHT - top_fixed - bottom_fixed;
+  lcd_scroll_offset = 0;
+  lcd_command(LCD_SCROLL_DEFINE);
+  lcd_data_16(top_fixed);
+  lcd_data_16(lcd_scroll_height);
+  lcd_data_16(bottom_fixed);
+  lcd_command(LCD_SCROLL_START);
+  lcd_data_16(top_fixed);
+  }
+
+/******************************************************************************
+ * Fills rows of the scroll area with the background color
+ * first         - first row, relative to the scroll area in memory
+ * n             - number of rows
+ */
+static void lcd_scroll_clear(uint16_t first, uint16_t n) {
+  uint16_t part = lcd_scroll_height - first;
+  if (n > part) {
+    lcd_scroll_clear(0, n - part);
+    n = part;
+    }
+  lcd_set_window(0,LCD_WIDTH-1,lcd_scroll_top+first,lcd_scroll_top+first+n-1);
+  lcd_send_pixels(background_packed, (uint32_t)LCD_WIDTH * n);
+  }
+
+/******************************************************************************
+ * Scrolls the content of the scroll area. Only the lines moved into view
+ * are drawn, using the background color.
+ * lines         - number of lines to move the content up (negative: down)
+ */
+void lcd_scroll(int16_t lines) {
+  uint16_t n = (lines < 0) ? -lines : lines;
+  if (!lcd_scroll_height || !lines || lcd_madctl != LCD_MADCTL_FLAGS)
+    return;   //rows are not memory rows when rotated
+  lcd_font_flush();
+  if (n > lcd_scroll_height)
+    n = lcd_scroll_height;
+  if (lines > 0) {
+    //old top lines are shown at the bottom
+    lcd_scroll_clear(lcd_scroll_offset, n);
+    lcd_scroll_offset += n;
+    if (lcd_scroll_offset >= lcd_scroll_height)
+      lcd_scroll_offset -= lcd_scroll_height;
+    }
+  else {
+    //old bottom lines are shown at the top
+    if (lcd_scroll_offset < n)
+      lcd_scroll_offset += lcd_scroll_height;
+    lcd_scroll_offset -= n;
+    lcd_scroll_clear(lcd_scroll_offset, n);
+    }
+  lcd_command(LCD_SCROLL_START);
+  lcd_data_16(lcd_scroll_top + lcd_scroll_offset);
+  }
+
+/******************************************************************************
+ * Returns the memory row shown at a given line of the screen
+ * y             - line on the screen
+ */
+uint16_t lcd_scroll_map_row(uint16_t y) {
+  if (y < lcd_scroll_top || y >= lcd_scroll_top + lcd_scroll_height)
+    return y;
+  y += lcd_scroll_offset;
+  if (y >= lcd_scroll_top + lcd_scroll_height)
+    y -= lcd_scroll_height;
+  return y;
+  }
+#endif
+
+
+//=============================================================================
+//Reading display memory and blending
+// The display returns a dummy byte after LCD_READ_MEM, followed by 3 bytes
+// (red, green, blue, 6 bits each, left aligned) per pixel.
+//=============================================================================
+#if LCD_USE_READBACK == 1
+
+//Foreground contributions for all 16 alpha values, calculated once per call
+typedef struct {
+  uint16_t fg;
+  uint8_t  r[16];
+  uint8_t  g[16];
+  uint8_t  b[16];
+  } lcd_alpha_t;
+
+
+/******************************************************************************
+ * Reads a part of a row from the display memory
+ * x, y          - first pixel
+ * w             - number of pixels
+ * buffer        - receives the packed colors
+ */
+void lcd_read_row(uint16_t x, uint16_t y, uint16_t w, uint16_t* buffer) {
+  uint8_t r, g;
+  lcd_font_flush();
+  lcd_set_column(x,x+w-1);
+  lcd_set_page(y,y);
+  lcd_command(LCD_READ_MEM);
+  lcd_bus_wait();
+  LCD_DATA();
+  lcd_bus_read();  //dummy
+  for (; w; w--) {
+    r = lcd_bus_read();
+    g = lcd_bus_read();
+    *buffer++ = ((uint16_t)(r >> 3) << 11) | ((uint16_t)(g >> 2) << 5) | (lcd_bus_read() >> 3);
+    }
+  lcd_bus_read_end();
+  }
+
+
+/******************************************************************************
+ * Prepares the alpha table for a color
+ */
+static void lcd_alpha_init(lcd_alpha_t *t, color_t c) {
+  t->fg = lcd_pack_color(c);
+  for (uint8_t a = 0; a < 16; a++) {
+    t->r[a] = (c.red   * a * 17) >> 8;
+    t->g[a] = (c.green * a * 17) >> 8;
+    t->b[a] = (c.blue  * a * 17) >> 8;
+    }
+  }
+
+
+/******************************************************************************
+ * Blends a color with a packed pixel
+ * d             - pixel from display
+ * a             - alpha of foreground, 0 to 15
+ */
+static uint16_t lcd_alpha_blend(const lcd_alpha_t *t, uint16_t d, uint8_t a) {
+  uint8_t w = (15 - a) * 17;   //weight of display content, 1/256 units
+  if (a == 0)  return d;
+  if (a >= 15) return t->fg;
+  return ((uint16_t)(t->r[a] + (((d >> 11)       * w) >> 8)) << 11) |
+         ((uint16_t)(t->g[a] + ((((d >> 5) & 63) * w) >> 8)) << 5)  |
+                    (t->b[a] + (((d & 31)        * w) >> 8));
+  }
+
+
+/******************************************************************************
+ * Blends a rectangle with the display content, row by row. Alpha values
+ * are read from the map or, if it is 0, alpha is used for all pixels.
+ */
+static void lcd_blend(PGM_P alpha_map, uint8_t alpha, uint16_t x, uint16_t y, 
+                      uint16_t w, uint16_t h, color_t c) {
+  uint16_t    buffer[LCD_READBACK_BUFFER];
+  uint16_t    stride = (w+1)/2;
+  uint16_t    x0, n, i, px;
+  lcd_alpha_t t;
   
+  if (x >= lcd_width || y >= lcd_height)
+    return;
+  lcd_alpha_init(&t, c);
+  if (h > lcd_height - y)
+    h = lcd_height - y;
+  if (w > lcd_width - x)
+    w = lcd_width - x;
+  for (; h; h--, y++, alpha_map += alpha_map ? stride : 0) {
+    for (x0 = 0; x0 < w; x0 += n) {
+      n = w - x0;
+      if (n > LCD_READBACK_BUFFER)
+        n = LCD_READBACK_BUFFER;
+      lcd_read_row(x+x0, y, n, buffer);
+      for (i = 0; i < n; i++) {
+        px = x0 + i;
+        if (alpha_map)
+          alpha = pgm_read_byte(alpha_map + px/2) >> ((px & 1) ? 4 : 0);
+        buffer[i] = lcd_alpha_blend(&t, buffer[i], alpha & 0x0F);
+        }
+      lcd_set_window(x+x0,x+x0+n-1,y,y);
+      for (i = 0; i < n; i++)
+        lcd_send_packed(buffer[i]);
+      }
+    }
+  }
+
+
+/******************************************************************************
+ * Draws a semi-transparent rectangle
+ * x, y          - upper left corner
+ * w, h          - width and height
+ * c             - color of the rectangle
+ * alpha         - opacity, 0 (transparent) to 15 (opaque)
+ */
+void lcd_blend_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, color_t c, uint8_t alpha) {
+  lcd_blend(0, alpha, x, y, w, h, c);
+  }
+
+
+/******************************************************************************
+ * Draws a color through an alpha map, e.g. an anti-aliased glyph
+ * alpha_map     - 4 bit alpha values from flash, see header file
+ * x, y          - upper left corner
+ * w, h          - width and height of the alpha map
+ * c             - the color
+ */
+void lcd_blend_alpha_P(PGM_VOID_P alpha_map, uint16_t x, uint16_t y, uint16_t w, uint16_t h, color_t c) {
+  lcd_blend((PGM_P)alpha_map, 0, x, y, w, h, c);
+  }
+#endif
+
+
+//=============================================================================
+//Images from flash
+//=============================================================================
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+
+//Position within the image while decoding, used to clip the image
+typedef struct {
+  uint16_t col;       //current column in image
+  uint16_t width;     //width of image
+  uint16_t visible_w; //visible columns
+  uint16_t visible_h; //visible rows left
+  } lcd_image_pos_t;
+
+/******************************************************************************
+ * Sends count pixels of the same color, skipping pixels outside the screen
+ * Returns 0 when all visible rows are done
+ */
+static uint8_t lcd_image_pixels(lcd_image_pos_t *p, uint16_t c, uint16_t count) {
+  uint16_t n;
+  while (count && p->visible_h) {
+    n = p->width - p->col;
+    if (n > count)
+      n = count;
+    if (p->col < p->visible_w)
+      lcd_send_pixels(c, (p->col + n <= p->visible_w) ? n : p->visible_w - p->col);
+    p->col += n;
+    count  -= n;
+    if (p->col == p->width) {
+      p->col = 0;
+      p->visible_h--;
+      }
+    }
+  return p->visible_h != 0;
+  }
+
+/******************************************************************************
+ * Reads one pixel from the image data
+ */
+static inline uint16_t lcd_image_read(PGM_P *src, PGM_P palette) {
+  uint16_t c;
+  if (palette) {
+    c = 2 * (uint8_t)pgm_read_byte((*src)++);
+    return (pgm_read_byte(palette + c) << 8) | pgm_read_byte(palette + c + 1);
+    }
+  c = pgm_read_byte((*src)++) << 8;
+  return c | pgm_read_byte((*src)++);
+  }
+
+/******************************************************************************
+ * This function draws an image from flash at the given position. The image
+ * is decoded while it is sent to the display in one address window.
+ * progmem_image - image data as described in the header file
+ * x, y          - upper left corner of the image
+ */
+static void lcd_draw_image(PGM_VOID_P progmem_image, uint16_t x, uint16_t y) {
+  PGM_P   src      = (PGM_P)progmem_image;
+  PGM_P   palette  = 0;
+  uint8_t encoding = pgm_read_byte(src++);
+  uint8_t token, n;
+  uint16_t c;
+  uint16_t h;
+  lcd_image_pos_t p;
+  
+  p.col   = 0;
+  p.width = pgm_read_byte(src) | (pgm_read_byte(src+1) << 8);
+  h       = pgm_read_byte(src+2) | (pgm_read_byte(src+3) << 8);
+  src    += 4;
+  if (x >= lcd_width || y >= lcd_height || !p.width || !h)
+    return;
+  p.visible_w = (p.width < lcd_width - x)  ? p.width : lcd_width - x;
+  p.visible_h = (h       < lcd_height - y) ? h       : lcd_height - y;
+  
+  if (encoding == LCD_IMAGE_PALETTE) {
+    palette = src + 1;
+    n       = pgm_read_byte(src);
+    src     = palette + (n ? 2*n : 512);
+    }
+  
+  lcd_font_flush();
+  lcd_set_window(x,x+p.visible_w-1,y,y+p.visible_h-1);
+  
+  if (encoding == LCD_IMAGE_RAW) {
+    do {
+      c = lcd_image_read(&src, 0);
+      } while (lcd_image_pixels(&p, c, 1));
+    return;
+    }
   
+  do {
+    token = pgm_read_byte(src++);
+    if (token & 0x80) {
+      c = lcd_image_read(&src, palette);
+      if (!lcd_image_pixels(&p, c, token - 0x80 + 2))
+        return;
+      }
+    else {
+      for (n = token+1; n; n--) {
+        c = lcd_image_read(&src, palette);
+        if (!lcd_image_pixels(&p, c, 1))
+          return;
+        }
+      }
+    } while (1);
+  }
+
+/******************************************************************************
+ * Draws an image, see lcd_draw_image, timed as LCD_SPAN_IMAGE
+ */
+void lcd_draw_image_xy_P(PGM_VOID_P progmem_image, uint16_t x, uint16_t y) {
+  LCD_SPAN_BEGIN();
+  lcd_draw_image(progmem_image, x, y);
+  LCD_SPAN_END(LCD_SPAN_IMAGE);
+  }
+#endif
+
+
+//=============================================================================
+//Band renderer
+// The screen is drawn in bands of LCD_BAND_HEIGHT lines into an indexed 
+// color buffer. Each band is expanded through the palette while sending and
+// skipped if its content did not change since the last frame.
+//=============================================================================
+#if LCD_BAND_BPP > 0
+
+#define LCD_BAND_WIDTH  ((LCD_WIDTH > LCD_HEIGHT) ? LCD_WIDTH : LCD_HEIGHT)
+#define LCD_BAND_COUNT  ((LCD_BAND_WIDTH+LCD_BAND_HEIGHT-1)/LCD_BAND_HEIGHT)
+#define LCD_BAND_SIZE   ((uint16_t)LCD_BAND_WIDTH*LCD_BAND_HEIGHT*LCD_BAND_BPP/8)
+#define LCD_BAND_NONE   0xFFFF
+
+uint8_t  lcd_band_buffer[LCD_BAND_SIZE];
+uint16_t lcd_palette[1<<LCD_BAND_BPP];
+uint32_t lcd_band_hash[LCD_BAND_COUNT];
+uint8_t  lcd_band_valid = 0;
+uint16_t lcd_band_top = LCD_BAND_NONE;   //first line of band being drawn
+uint8_t  lcd_band_text_fg = 1;
+int16_t  lcd_band_text_bg = 0;
+
+
+/******************************************************************************
+ * Forces all bands to be sent with the next frame
+ */
+void lcd_band_invalidate(void) {
+  lcd_band_valid = 0;
+  }
+
+
+/******************************************************************************
+ * Sets a palette entry. All bands are sent again with the next frame.
+ * index         - palette index
+ * c             - the color
+ */
+void lcd_band_set_palette(uint8_t index, color_t c) {
+  lcd_palette[index] = lcd_pack_color(c);
+  lcd_band_invalidate();
+  }
+
+
+/******************************************************************************
+ * Sets the palette indices used for text drawn into bands
+ * fg            - index for the text
+ * bg            - index for the background, -1 for transparent
+ */
+void lcd_band_set_text_color(uint8_t fg, int16_t bg) {
+  lcd_band_text_fg = fg;
+  lcd_band_text_bg = bg;
+  }
+
+
+/******************************************************************************
+ * Sets a pixel in the current band, pixels outside the band are ignored
+ * x, y          - screen coordinates of the pixel
+ * index         - palette index
+ */
+void lcd_band_set_pixel(uint16_t x, uint16_t y, uint8_t index) {
+  uint16_t pos;
+  y -= lcd_band_top;
+  if (x >= lcd_width || y >= LCD_BAND_HEIGHT)
+    return;
+  pos = y*lcd_width + x;
+#if LCD_BAND_BPP == 4
+  if (pos & 1)
+    lcd_band_buffer[pos>>1] = (lcd_band_buffer[pos>>1] & 0x0F) | (index << 4);
+  else
+    lcd_band_buffer[pos>>1] = (lcd_band_buffer[pos>>1] & 0xF0) | (index & 0x0F);
+#else
+  lcd_band_buffer[pos] = index;
+#endif
+  }
+
+
+/******************************************************************************
+ * Fills a rectangle in the current band, clipped to the band
+ * x, y          - upper left corner in screen coordinates
+ * w, h          - width and height of the rectangle
+ * index         - palette index
+ */
+void lcd_band_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t index) {
+  uint16_t top    = lcd_band_top;
+  uint16_t bottom = top + LCD_BAND_HEIGHT;
+  if (y < top) {
+    if (y + h <= top)
+      return;
+    h -= top - y;
+    y  = top;
+    }
+  if (y + h > bottom)
+    h = (y < bottom) ? bottom - y : 0;
+  if (x >= lcd_width)
+    return;
+  if (w > lcd_width - x)
+    w = lcd_width - x;
+  for (; h; h--, y++) {
+#if LCD_BAND_BPP == 8
+    memset(&lcd_band_buffer[(y-top)*lcd_width + x], index, w);
+#else
+    for (uint16_t i = 0; i < w; i++)
+      lcd_band_set_pixel(x+i, y, index);
+#endif
+    }
+  }
+
+
+/******************************************************************************
+ * Draws a font byte into the current band
+ * b             - Bit pattern to display
+ */
+static void lcd_band_font_byte(uint8_t b) {
+  uint16_t y = lcd_current_row;
+  for (uint8_t i=0; i<8; i++, y++, b >>= 1) {
+    if (b & 1)
+      lcd_band_set_pixel(lcd_current_column, y, lcd_band_text_fg);
+    else if (lcd_band_text_bg >= 0)
+      lcd_band_set_pixel(lcd_current_column, y, lcd_band_text_bg);
+    }
+  }
+
+
+/******************************************************************************
+ * Calculates a hash of the band buffer to detect changes
+ */
+static uint32_t lcd_band_get_hash(void) {
+  uint32_t h = 5381;
+  uint16_t n = lcd_width*LCD_BAND_HEIGHT*LCD_BAND_BPP/8;
+  for (uint16_t i = 0; i < n; i++)
+    h = (h << 5) + h + lcd_band_buffer[i];
+  return h;
+  }
+
+
+/******************************************************************************
+ * Sends the band buffer to the display, expanding indices through the palette
+ * top, bottom   - first and last line of the band
+ */
+static void lcd_band_send(uint16_t top, uint16_t bottom) {
+  uint16_t n = (bottom - top + 1) * (lcd_width*LCD_BAND_BPP/8);
+  uint8_t *p = lcd_band_buffer;
+  lcd_set_window(0,lcd_width-1,top,bottom);
+  for (; n; n--, p++) {
+#if LCD_BAND_BPP == 4
+    lcd_send_packed(lcd_palette[*p & 0x0F]);
+    lcd_send_packed(lcd_palette[*p >> 4]);
+#else
+    lcd_send_packed(lcd_palette[*p]);
+#endif
+    }
+  }
+
+
+/******************************************************************************
+ * Draws a frame. For each band the buffer is cleared to index 0, draw is
+ * called and the band is sent if its content changed.
+ * draw          - function drawing the content of a band
+ */
+void lcd_band_render(lcd_band_draw_t draw) {
+  uint16_t top, bottom;
+  uint32_t h;
+  lcd_font_flush();
+  for (uint8_t band = 0; band*LCD_BAND_HEIGHT < lcd_height; band++) {
+    top    = band * LCD_BAND_HEIGHT;
+    bottom = top + LCD_BAND_HEIGHT - 1;
+    if (bottom >= lcd_height)
+      bottom = lcd_height - 1;
+    memset(lcd_band_buffer, 0, LCD_BAND_SIZE);
+    lcd_band_top = top;
+    draw(top, bottom);
+    lcd_band_top = LCD_BAND_NONE;
+    h = lcd_band_get_hash();
+    if (lcd_band_valid && h == lcd_band_hash[band])
+      continue;
+    lcd_band_hash[band] = h;
+    lcd_band_send(top, bottom);
+    }
+  lcd_band_valid = 1;
+  }
+#endif
+
+
 //=============================================================================
 //Compatibility functions to accept output of font generator
-// Pages are counted in units of 8 pixels!
+// Pages are counted in units of 8 pixels! Internally, the cursor is kept in
+// pixels, so text can be placed at any line with lcd_moveto_pixel.
 //=============================================================================
 
-uint16_t lcd_current_page = 0;
+uint16_t lcd_current_row = 0;
 uint16_t lcd_current_column = 0;
 
 
 /******************************************************************************
- * Changes the internal cursor by s pages
+ * Changes the internal cursor by s pages (8 pixel lines each)
  * s             - number of pages to move
  */ 
 uint16_t lcd_inc_page(int16_t s) {
-  uint16_t p = lcd_current_page;
-  p += s;
-  if (p > LCD_HEIGHT/8)
-    p = 0;
-  lcd_current_page = p;
-  
-  return p;
+  lcd_current_row += 8*s;   //no wrapping, output is clipped instead
+  return lcd_current_row/8;
   }
 
 /******************************************************************************
@@ -176,7 +1143,7 @@ uint16_t lcd_inc_page(int16_t s) {
 uint16_t lcd_inc_column(int16_t s) {
   uint16_t c = lcd_current_column;
   c += s;
-  if (c > LCD_WIDTH) 
+  if (c > lcd_width) 
     c = 0;
   lcd_current_column = c;
   return c;
@@ -190,7 +1157,17 @@ uint16_t lcd_inc_column(int16_t s) {
  */ 
 void lcd_moveto_xy(uint16_t page, uint16_t column) {
   lcd_current_column = column; 
-  lcd_current_page = page;
+  lcd_current_row = 8*page;
+  }
+
+/******************************************************************************
+ * Moves the cursor to the given pixel position
+ * x             - column of the left edge of the next character
+ * y             - line of the top edge of the next character
+ */ 
+void lcd_moveto_pixel(uint16_t x, uint16_t y) {
+  lcd_current_column = x; 
+  lcd_current_row = y;
   }
 
 /******************************************************************************
@@ -199,25 +1176,212 @@ void lcd_moveto_xy(uint16_t page, uint16_t column) {
  * columns       - number of columns to move
  */  
 void lcd_move_xy(int16_t pages, int16_t columns) {
-  lcd_moveto_xy(lcd_inc_page(pages),lcd_inc_column(columns));
+  lcd_inc_page(pages);
+  lcd_inc_column(columns);
   }
 
 
 /******************************************************************************
- * Takes a vertical byte from the font generator and prints it on the display
+ * Font bytes waiting to be written: all bytes are on the same row and in 
+ * consecutive columns, starting at lcd_font_column.
+ */
+uint8_t  lcd_font_buffer[LCD_FONT_BUFFER_SIZE];
+uint8_t  lcd_font_count = 0;
+uint16_t lcd_font_row;
+uint16_t lcd_font_column;
+uint8_t  lcd_text_mode = LCD_TEXT_OPAQUE;
+
+
+#if LCD_FONT_EXCHANGE_XY == 1
+/******************************************************************************
+ * Opaque text is sent directly, with rows and columns exchanged. In this mode
+ * the display fills a window column by column, from top to bottom, just like
+ * the vertical bytes of the font generator. The window is opened up to the 
+ * right edge of the screen and kept open as long as bytes are written to 
+ * consecutive columns on the same page.
+ */
+uint8_t  lcd_font_stream = 0;       //exchanged mode active
+uint16_t lcd_font_stream_row;       //position of next byte in open window
+uint16_t lcd_font_stream_column;
+
+/******************************************************************************
+ * Writes a font byte as column of 8 pixels
+ * Returns 0 if the byte has to be written by the buffered path
+ */
+static uint8_t lcd_font_stream_byte(uint8_t b) {
+  uint16_t top = lcd_current_row;
+  if (lcd_current_column >= lcd_width || top + 8 > lcd_height)
+    return 0;
+  top = lcd_scroll_map_row(top);
+  if (!lcd_font_stream || lcd_current_row    != lcd_font_stream_row
+                       || lcd_current_column != lcd_font_stream_column) {
+    if (!lcd_font_stream)
+      lcd_command_1(LCD_MIRROR, lcd_madctl ^ LCD_FLIP_XY);
+    lcd_font_stream     = 1;
+    lcd_font_stream_row = lcd_current_row;
+    lcd_set_window(top,top+7,lcd_current_column,lcd_width-1);
+    }
+  for (uint8_t i = 8; i; i--, b >>= 1)
+    lcd_send_packed((b & 1) ? foreground_packed : background_packed);
+  lcd_font_stream_column = lcd_current_column + 1;
+  return 1;
+  }
+#endif
+
+
+/******************************************************************************
+ * Takes a vertical byte from the font generator and stores it until a full
+ * row of the text is available
  * b             - Bit pattern to display
  */ 
 void lcd_write_font_byte(uint8_t b) {
-  lcd_set_page(8*lcd_current_page,8*lcd_current_page+8);
-  lcd_set_column(lcd_current_column,lcd_current_column);
-  lcd_command(LCD_WRITE_MEM);
-  for(uint8_t i=0;i<8;i++) {
-    if(b&1)
-      lcd_send_pixel(foreground);
-    else
-      lcd_send_pixel(background);
-    b = b>>1;
+#if LCD_BAND_BPP > 0
+  if (lcd_band_top != LCD_BAND_NONE) {
+    lcd_band_font_byte(b);
+    lcd_inc_column(1);
+    return;
     }
+#endif
+#if LCD_FONT_EXCHANGE_XY == 1
+  if (lcd_text_mode == LCD_TEXT_OPAQUE && !lcd_font_count && lcd_font_stream_byte(b)) {
+    lcd_inc_column(1);
+    return;
+    }
+#endif
+  if (lcd_font_count && (lcd_current_row    != lcd_font_row ||
+                         lcd_current_column != lcd_font_column + lcd_font_count ||
+                         lcd_font_count     == LCD_FONT_BUFFER_SIZE))
+    lcd_font_flush();
+  if (!lcd_font_count) {
+    lcd_font_row    = lcd_current_row;
+    lcd_font_column = lcd_current_column;
+    }
+  lcd_font_buffer[lcd_font_count++] = b;
   lcd_inc_column(1);
   }
-  
\ No newline at end of file
+
+
+/******************************************************************************
+ * Selects how text is drawn
+ * mode          - LCD_TEXT_OPAQUE: foreground and background pixels
+ *                 LCD_TEXT_TRANSPARENT: foreground pixels only
+ *                 LCD_TEXT_AUTO: foreground only, unless painting the 
+ *                 background as well needs fewer bytes. Use if the area
+ *                 below the text has the background color.
+ */
+void lcd_set_text_mode(uint8_t mode) {
+  lcd_font_flush();
+  lcd_text_mode = mode;
+  }
+
+
+/******************************************************************************
+ * Counts the set bits in a byte
+ */
+static inline uint8_t lcd_count_bits(uint8_t b) {
+  uint8_t n = 0;
+  for (; b; b &= b-1)
+    n++;
+  return n;
+  }
+
+
+/******************************************************************************
+ * Writes only the set pixels of the stored font bytes. Each run of set bits 
+ * in a byte is written with its own window, the column is set once per byte.
+ * n             - number of bytes to write
+ * top           - first line of the text
+ * mask          - bits of each byte inside the screen
+ */
+static void lcd_font_flush_transparent(uint8_t n, uint16_t top, uint8_t mask) {
+  uint8_t b, row, len;
+  for(uint8_t i=0;i<n;i++) {
+    b = lcd_font_buffer[i] & mask;
+    if (!b)
+      continue;
+    lcd_set_column(lcd_font_column+i,lcd_font_column+i);
+    row = 0;
+    while (b) {
+      for (; !(b & 1); b >>= 1)
+        row++;
+      for (len = 0; b & 1; b >>= 1)
+        len++;
+      lcd_set_page(top+row,top+row+len-1);
+      lcd_write_mem_start();
+      lcd_send_pixels(foreground_packed,len);
+      row += len;
+      }
+    }
+  }
+
+
+/******************************************************************************
+ * Returns the number of bytes sent by lcd_font_flush_transparent: 
+ * 5 bytes per column and 6 bytes plus 2 per pixel for each run
+ */
+static uint16_t lcd_font_transparent_cost(uint8_t n, uint8_t mask) {
+  uint16_t cost = 0;
+  uint8_t  b;
+  for(uint8_t i=0;i<n;i++) {
+    b = lcd_font_buffer[i] & mask;
+    if (b)
+      cost += 5 + 6*lcd_count_bits(b & ~(b << 1)) + 2*lcd_count_bits(b);
+    }
+  return cost;
+  }
+
+
+/******************************************************************************
+ * Writes all stored font bytes using one address window. The pixels are sent
+ * row by row, with precomputed foreground and background colors.
+ * In transparent mode, only foreground pixels are written.
+ * Ends the exchanged row/column mode used for opaque text.
+ */ 
+static void lcd_font_flush_buffer(void) {
+  uint8_t  n = lcd_font_count;
+  uint8_t  rows = 8;
+  uint16_t top = lcd_font_row;
+#if LCD_FONT_EXCHANGE_XY == 1
+  if (lcd_font_stream) {
+    lcd_font_stream = 0;
+    lcd_command_1(LCD_MIRROR, lcd_madctl);
+    }
+#endif
+  if (!n)
+    return;
+  lcd_font_count = 0;
+  if (lcd_font_column >= lcd_width || top >= lcd_height)
+    return;
+  if (top + 8 > lcd_height)   //text row not aligned to pages may be cut
+    rows = lcd_height - top;
+  top = lcd_scroll_map_row(top);
+  if (n > lcd_width - lcd_font_column)
+    n = lcd_width - lcd_font_column;
+  if (lcd_text_mode == LCD_TEXT_TRANSPARENT ||
+     (lcd_text_mode == LCD_TEXT_AUTO && lcd_font_transparent_cost(n,(1<<rows)-1) < 11 + 2*n*rows)) {
+    lcd_font_flush_transparent(n,top,(1<<rows)-1);
+    return;
+    }
+  lcd_set_window(lcd_font_column,lcd_font_column+n-1,top,top+rows-1);
+  for(uint8_t mask = 1; mask && rows; mask <<= 1, rows--) {
+    for(uint8_t i=0;i<n;i++) {
+      if(lcd_font_buffer[i] & mask)
+        lcd_send_packed(foreground_packed);
+      else
+        lcd_send_packed(background_packed);
+      }
+    }
+  }
+
+/******************************************************************************
+ * Writes the collected font bytes, timed as LCD_SPAN_FLUSH if there are any
+ */
+void lcd_font_flush(void) {
+  if (!lcd_font_count) {
+    lcd_font_flush_buffer();    //only ends streamed text
+    return;
+    }
+  LCD_SPAN_BEGIN();
+  lcd_font_flush_buffer();
+  LCD_SPAN_END(LCD_SPAN_FLUSH);
+  }
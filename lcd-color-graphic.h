@@ -42,9 +42,64 @@ extern void init_spi_lcd(void);
 //Define a function that waits until SPI interface is idle
 #define spi_wait_for_idle() while(! (SPSR0 & _BV(SPIF0)));
 
+//Define how to test if the SPI interface is idle (optional, used to count
+//the loops waiting for the bus with LCD_USE_STATS)
+#define spi_idle()   (SPSR0 & _BV(SPIF0))
+
 //Define how to write to SPI data register
 #define spi_write(i) SPDR0 = i
 
+//Define how to read the SPI data register (only needed with LCD_USE_READBACK)
+#define spi_read()   SPDR0
+
+//Include graphic functions, i.e. lcd_draw_image_xy_P ? 
+#define LCD_INCLUDE_GRAPHIC_FUNCTIONS  1
+
+//Number of font bytes collected before they are sent in one address window
+#define LCD_FONT_BUFFER_SIZE  64
+
+//Write opaque text with exchanged rows and columns (LCD_FLIP_XY), so font 
+//bytes can be sent directly as vertical columns of 8 pixels
+#define LCD_FONT_EXCHANGE_XY  1
+
+//Additional bits for LCD_MIRROR, e.g. LCD_BGR
+#define LCD_MADCTL_FLAGS      0
+
+//Include hardware vertical scrolling (lcd_scroll_define, lcd_scroll)?
+//(host tests set it on the command line)
+#ifndef LCD_USE_SCROLLING
+  #define LCD_USE_SCROLLING   0
+#endif
+
+//Read display memory back for blending (lcd_blend_*)? Needs MISO connected.
+//Memory is read in parts of up to LCD_READBACK_BUFFER pixels of one row.
+//(host tests set it on the command line)
+#ifndef LCD_USE_READBACK
+  #define LCD_USE_READBACK    0
+#endif
+#define LCD_READBACK_BUFFER   32
+
+//Band renderer: drawing into an indexed color buffer of LCD_BAND_HEIGHT lines
+//of the larger side of the display, only changed bands are sent to the display.
+//Bits per pixel: 0 (no band renderer), 4 (16 colors) or 8 (256 colors)
+//(host tests set it on the command line)
+#ifndef LCD_BAND_BPP
+  #define LCD_BAND_BPP   0
+#endif
+#define LCD_BAND_HEIGHT  16
+
+//Count bytes, commands, glyph lookups etc. in lcd_stats for diagnostics?
+//See lcd-stats.h. Without it, no code or memory is used.
+#define LCD_USE_STATS    0
+
+//Measure the time of text output, images, clearing and flushing in 
+//lcd_timing (see lcd-stats.h)? LCD_TIMER() has to read a free running
+//counter of type LCD_TIMER_TYPE. Longer spans than one period of the
+//counter are not measured correctly.
+#define LCD_USE_TIMING  0
+#define LCD_TIMER()     TCNT1
+#define LCD_TIMER_TYPE  uint16_t
+
 /*Example SPI setup (Atmega162)
  *init spi: msb first, update on falling edge , read on rising edge, 9 MHz
  *void init_spi_lcd() {
@@ -66,6 +121,11 @@ typedef struct {
     uint8_t blue;
     } color_t;
 
+//Packs a color to the 16 bit format (RGB565) used by the display
+static inline uint16_t lcd_pack_color(color_t c) {
+  return ((uint16_t)c.red << 11) | ((uint16_t)c.green << 5) | c.blue;
+  }
+
 
 /*****************************************************************************
  * Public Functions
@@ -82,17 +142,84 @@ typedef struct {
  void lcd_set_foreground(uint8_t r, uint8_t g, uint8_t b);
  void lcd_set_background(uint8_t r, uint8_t g, uint8_t b);
   
+//Rotate the screen (LCD_ROTATE_*), width and height are swapped for 90 and 270
+ void lcd_set_rotation(uint8_t rotation);
+ extern uint16_t lcd_width;
+ extern uint16_t lcd_height;
+  
 //set display area for next write accesses
  void lcd_set_page(uint16_t start, uint16_t end);
  void lcd_set_column(uint16_t start, uint16_t end);
 
 //write pixel data in 16 bit color mode. Display must be in write mode
  void lcd_send_pixel(color_t c);
+//write count pixels of the same packed color. Display must be in write mode
+ void lcd_send_pixels(uint16_t c, uint32_t count);
+//set the address window and start writing to display memory
+ void lcd_set_window(uint16_t col0, uint16_t col1, uint16_t page0, uint16_t page1);
 
 //Set a pixel at a given location to the foreground color
  void lcd_set_pixel_xy(uint16_t column, uint16_t page); 
 //Set an area to the background color
  void lcd_set_area_xy(uint16_t col0, uint16_t col1, uint16_t page0, uint16_t page1);
+//Fill a rectangle with the given color
+ void lcd_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, color_t c);
+
+//Drawing functions using the foreground color, shapes may be partially outside
+//of the screen. x0/y0 and x1/y1 are corners, cx/cy are centers
+ void lcd_draw_hline(int16_t x, int16_t y, int16_t w);
+ void lcd_draw_vline(int16_t x, int16_t y, int16_t h);
+ void lcd_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+ void lcd_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h);
+ void lcd_draw_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r);
+ void lcd_fill_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r);
+ void lcd_draw_circle(int16_t cx, int16_t cy, int16_t r);
+ void lcd_fill_circle(int16_t cx, int16_t cy, int16_t r);
+//Plot many points at once, the array is sorted by this function
+ typedef struct {
+   int16_t x;
+   int16_t y;
+   } lcd_point_t;
+ void lcd_plot_points(lcd_point_t *points, uint16_t count);
+
+//Hardware scrolling of the area between top_fixed and bottom_fixed lines
+//(rotation 0 only, both functions do nothing otherwise). Text is placed on 
+//the scrolled lines, other drawing functions use memory rows, see 
+//lcd_scroll_map_row.
+#if LCD_USE_SCROLLING == 1
+ void lcd_scroll_define(uint16_t top_fixed, uint16_t bottom_fixed);
+ void lcd_scroll(int16_t lines);
+ uint16_t lcd_scroll_map_row(uint16_t y);
+#else
+ static inline uint16_t lcd_scroll_map_row(uint16_t y) {return y;}
+#endif
+
+//Read pixels from display memory and blend colors with the display content
+//alpha ranges from 0 (transparent) to 15 (opaque). alpha_map holds 4 bit 
+//alpha values, two per byte (left pixel in lower bits), each row starting 
+//with a new byte
+#if LCD_USE_READBACK == 1
+ void lcd_read_row(uint16_t x, uint16_t y, uint16_t w, uint16_t* buffer);
+ void lcd_blend_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, color_t c, uint8_t alpha);
+ void lcd_blend_alpha_P(PGM_VOID_P alpha_map, uint16_t x, uint16_t y, uint16_t w, uint16_t h, color_t c);
+#endif
+
+//Draw an image from flash, see the image format below
+#if LCD_INCLUDE_GRAPHIC_FUNCTIONS >= 1
+ void lcd_draw_image_xy_P(PGM_VOID_P progmem_image, uint16_t x, uint16_t y);
+#endif
+
+//Band renderer: draw is called for each band with the first and last line
+//of the band and uses the lcd_band_* functions and the text functions
+#if LCD_BAND_BPP > 0
+ typedef void (*lcd_band_draw_t)(uint16_t top, uint16_t bottom);
+ void lcd_band_render(lcd_band_draw_t draw);
+ void lcd_band_invalidate(void);
+ void lcd_band_set_palette(uint8_t index, color_t c);
+ void lcd_band_set_text_color(uint8_t fg, int16_t bg);
+ void lcd_band_set_pixel(uint16_t x, uint16_t y, uint8_t index);
+ void lcd_band_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t index);
+#endif
 
  
  
@@ -103,12 +230,45 @@ typedef struct {
  uint16_t lcd_inc_column(int16_t s);
  void lcd_moveto_xy(uint16_t page, uint16_t column);
  void lcd_move_xy(int16_t pages, int16_t columns);
+//Text position in pixels, lines need not be aligned to pages
+ void lcd_moveto_pixel(uint16_t x, uint16_t y);
 //Function to read the current position
- extern uint16_t lcd_current_page;
+ extern uint16_t lcd_current_row;
  extern uint16_t lcd_current_column;
- static inline uint16_t lcd_get_position_page(void)   {return lcd_current_page;}
+ static inline uint16_t lcd_get_position_page(void)   {return lcd_current_row/8;}
  static inline uint16_t lcd_get_position_column(void) {return lcd_current_column;}
+ static inline uint16_t lcd_get_position_y(void)      {return lcd_current_row;}
  void lcd_write_font_byte(uint8_t b);
+//Sends font bytes collected by lcd_write_font_byte to the display
+ void lcd_font_flush(void);
+//Selects if the text background is drawn, see LCD_TEXT_* below
+ void lcd_set_text_mode(uint8_t mode);
+
+
+/*****************************************************************************
+ * Image format for lcd_draw_image_xy_P
+ * Header: encoding (1 byte), width and height (2 bytes each, LSB first)
+ *   LCD_IMAGE_RAW:      width*height pixels, RGB565 with MSB first
+ *   LCD_IMAGE_RLE:      tokens of RGB565 pixels
+ *   LCD_IMAGE_PALETTE:  number of colors (1 byte, 0 means 256), palette
+ *                       (RGB565, MSB first), tokens of palette indices
+ * Tokens:
+ *   0x00 - 0x7F: the next (token+1) pixels are copied
+ *   0x80 - 0xFF: the next pixel is repeated (token-0x80+2) times
+ * Images can be converted with tools/lcd-image-convert.py
+ *****************************************************************************/
+  #define LCD_IMAGE_RAW         0
+  #define LCD_IMAGE_RLE         2
+  #define LCD_IMAGE_PALETTE     3
+
+
+/*****************************************************************************
+ * Text modes for lcd_set_text_mode
+ *****************************************************************************/
+  #define LCD_TEXT_OPAQUE       0   //draw text and background
+  #define LCD_TEXT_TRANSPARENT  1   //draw text only
+  #define LCD_TEXT_AUTO         2   //draw text only or text and background,
+                                    //whichever needs fewer bytes
 
 
 /*****************************************************************************
@@ -123,11 +283,15 @@ typedef struct {
   #define LCD_SET_COLUMN        0x2A
   #define LCD_SET_PAGE          0x2B
   #define LCD_WRITE_MEM         0x2C
+  #define LCD_READ_MEM          0x2E
+  #define LCD_SCROLL_DEFINE     0x33
   #define LCD_MIRROR            0x36
+  #define LCD_SCROLL_START      0x37
   #define LCD_IDLE_MODE_OFF     0x38
   #define LCD_IDLE_MODE_ON      0x39
   #define LCD_COLOR_MODE        0x3A
   #define LCD_WRITE_CONTINUE    0x3C  
+  #define LCD_READ_CONTINUE     0x3E
  
 
 /*****************************************************************************
@@ -142,6 +306,12 @@ typedef struct {
   #define LCD_FLIP_XY           0x20
   #define LCD_BGR               0x08
 
+//Screen rotations for lcd_set_rotation
+  #define LCD_ROTATE_0          0
+  #define LCD_ROTATE_90         1
+  #define LCD_ROTATE_180        2
+  #define LCD_ROTATE_270        3
+
 
 
  
@@ -153,6 +323,7 @@ typedef struct {
 #define LCD_DATA()            PORT_DC |= _BV(PIN_DC)
 #define LCD_CMD()             PORT_DC &= ~_BV(PIN_DC)
 #define LCD_SET_OUTPUT_DC()   DDR_DC  |= _BV(PIN_DC)
+#define LCD_BUS_DC()          (PORT_DC & _BV(PIN_DC))
 
 //Control reset input of LCD
 #define LCD_RESET_OFF()       PORT_RST |= _BV(PIN_RST)
@@ -163,11 +334,11 @@ typedef struct {
 //Control pin for chip select
 #if LCD_USE_CHIPSELECT == 1
   #define LCD_SET_OUTPUT_CS()  DDR_CS  |= _BV(PIN_CS)
-  #define LCD_SELECT()         PORT_CS &= ~_BV(PIN_CS)
-  #define LCD_UNSELECT()       spi_wait_for_idle(); PORT_CS |= _BV(PIN_CS)
+  #define LCD_SELECT()         PORT_CS &= ~_BV(PIN_CS); LCD_BUS_SELECTED(1); LCD_STAT_INC(selects)
+  #define LCD_UNSELECT()       lcd_bus_wait(); PORT_CS |= _BV(PIN_CS); LCD_BUS_SELECTED(0)
 #else
   #define LCD_SET_OUTPUT_CS()  
-  #define LCD_SELECT()         spi_wait_for_idle();
+  #define LCD_SELECT()         lcd_bus_wait();
   #define LCD_UNSELECT()   
 #endif
 
@@ -176,6 +347,11 @@ typedef struct {
                                    LCD_SET_OUTPUT_RST(); \
                                    LCD_SET_OUTPUT_CS()
 
+//Bus to the display, the SPI routines above are used by LCD_TRANSPORT_SPI
+#include "lcd-stats.h"
+#include "lcd-transport.h"
+#include "lcd-transpose.h"
+
 
 
 
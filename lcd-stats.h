@@ -0,0 +1,84 @@
+#ifndef LCD_STATS_H_INCLUDED
+#define LCD_STATS_H_INCLUDED
+
+/******************************************************************************
+ * Counters and timing for diagnostics, used by dogm-graphic, 
+ * lcd-color-graphic and font
+ *
+ * Counters are enabled with LCD_USE_STATS in the config block of the display
+ * library. Otherwise LCD_STAT_INC / LCD_STAT_ADD expand to nothing and no
+ * memory is used. The counters wrap around, call lcd_stats_reset() before 
+ * measuring.
+ *
+ * Timing is enabled with LCD_USE_TIMING. Each call of a rendering function
+ * is a span, timed with LCD_TIMER(). Per group of functions (LCD_SPAN_*),
+ * lcd_timing keeps the number of calls, the shortest, the longest (worst
+ * case) and the sum of all spans in ticks of LCD_TIMER(). Spans nest, e.g.
+ * the font flush at the end of a string on the colour displays is counted
+ * for LCD_SPAN_TEXT and LCD_SPAN_FLUSH. Empty font flushes and calls of lcd_fill_rect outside
+ * the screen are not counted.
+ *
+ * Author:  Jan Michel (jan at mueschelsoft dot de)
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#if LCD_USE_STATS
+  typedef struct {
+    uint32_t bytes;         //bytes written to the bus, commands included
+    uint32_t commands;      //commands (lcd_command)
+    uint16_t address_sets;  //cursor or address window set on the display
+    uint16_t selects;       //chip select asserted
+    uint32_t bus_spins;     //loops waiting for the bus (SPI with spi_idle, USART)
+    uint16_t glyphs;        //characters looked up in a font
+    uint32_t width_bytes;   //width table bytes added up to find characters
+    uint16_t chars;         //characters written
+    } lcd_stats_t;
+
+  extern lcd_stats_t lcd_stats;
+
+  //Copies the counters to s
+  void lcd_stats_snapshot(lcd_stats_t *s);
+  //Sets all counters to 0
+  void lcd_stats_reset(void);
+
+  #define LCD_STAT_INC(c)    (lcd_stats.c++)
+  #define LCD_STAT_ADD(c,n)  (lcd_stats.c += (n))
+#else
+  #define LCD_STAT_INC(c)    ((void)0)
+  #define LCD_STAT_ADD(c,n)  ((void)0)
+#endif
+
+
+#define LCD_SPAN_TEXT    0  //lcd_put_char, lcd_put_string(_P,_length)
+#define LCD_SPAN_IMAGE   1  //images
+#define LCD_SPAN_CLEAR   2  //lcd_clear_area, colour: lcd_set_area_xy, lcd_fill_rect
+#define LCD_SPAN_FLUSH   3  //canvas flush and blit, colour: lcd_font_flush
+#define LCD_SPAN_COUNT   4
+
+#if LCD_USE_TIMING
+  typedef LCD_TIMER_TYPE lcd_ticks_t;
+
+  typedef struct {
+    lcd_ticks_t min;
+    lcd_ticks_t max;        //worst case
+    uint32_t    sum;
+    uint32_t    count;      //number of calls
+    } lcd_timing_t;
+
+  extern lcd_timing_t lcd_timing[LCD_SPAN_COUNT];
+
+  //Adds a span started at start to the given group
+  void lcd_timing_record(uint8_t span, lcd_ticks_t start);
+  //Copies the table to t (LCD_SPAN_COUNT entries)
+  void lcd_timing_snapshot(lcd_timing_t *t);
+  //Clears the table
+  void lcd_timing_reset(void);
+
+  #define LCD_SPAN_BEGIN()   lcd_ticks_t lcd_span_start = LCD_TIMER()
+  #define LCD_SPAN_END(s)    lcd_timing_record((s), lcd_span_start)
+#else
+  #define LCD_SPAN_BEGIN()
+  #define LCD_SPAN_END(s)    ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef LCD_TRANSPORT_H_INCLUDED
+#define LCD_TRANSPORT_H_INCLUDED
+
+/******************************************************************************
+ * Bus to the display, used by dogm-graphic and lcd-color-graphic
+ *
+ * Each back-end provides:
+ *   LCD_BUS_INIT()                  initializes the bus
+ *   lcd_bus_write(b)                writes one byte, waits until the bus can
+ *                                   take it but not until it is sent
+ *   lcd_bus_wait()                  waits until all bytes are sent, needed
+ *                                   before changing DC or chip select
+ *   lcd_bus_write_burst(p,n)        writes n bytes from RAM
+ *   lcd_bus_write_repeat(hi,lo,n)   writes the byte pair hi, lo n times
+ *   lcd_bus_read()                  reads one byte (not with all back-ends)
+ *   lcd_bus_read_end()              after the last read, before the next
+ *                                   write or lcd_bus_wait (optional)
+ * Written bytes and loops waiting for the bus are counted in lcd_stats
+ * (LCD_USE_STATS, see lcd-stats.h).
+ * DC and chip select are controlled by the display library (LCD_CMD,
+ * LCD_DATA / LCD_DRAM, LCD_SELECT, LCD_UNSELECT). LCD_CMD, LCD_DATA and
+ * LCD_DRAM only set the pin, callers wait for the bus before changing DC
+ * (dogm-graphic in lcd_bus_set_mode, lcd-color-graphic with lcd_bus_wait).
+ * LCD_UNSELECT waits before it releases chip select.
+ * Back-ends may define LCD_BUS_SELECTED(s) to follow chip select.
+ *
+ * Author:  Jan Michel (jan at mueschelsoft dot de)
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#define LCD_TRANSPORT_SPI       0   //SPI, using spi_write, spi_wait_for_idle,
+                                    //spi_read and spi_idle of the display library
+#define LCD_TRANSPORT_USART_SPI 1   //XMEGA USART in master SPI mode
+#define LCD_TRANSPORT_BITBANG   2   //any two (three) port pins
+#define LCD_TRANSPORT_PARALLEL  3   //8 bit 8080-type parallel bus
+#define LCD_TRANSPORT_HOST      4   //functions provided by a host program
+
+/*****************************************************************************
+ * BEGIN CONFIG BLOCK
+ *****************************************************************************/
+//Select the bus, see above (host builds set LCD_TRANSPORT_HOST)
+#ifndef LCD_TRANSPORT
+  #define LCD_TRANSPORT  LCD_TRANSPORT_SPI
+#endif
+
+//USART in SPI mode, e.g. USARTC0. Initialize it in LCD_INIT_SPI() and
+//leave TXCIF set, e.g. by sending LCD_NOP.
+#if LCD_TRANSPORT == LCD_TRANSPORT_USART_SPI
+  #define LCD_USART       USARTC0
+#endif
+
+//Clock, data out and (optional) data in for bit-bang SPI (mode 3)
+#if LCD_TRANSPORT == LCD_TRANSPORT_BITBANG
+  #define PORT_SCK        PORTB
+  #define DDR_SCK         DDRB
+  #define PIN_SCK         7
+  #define PORT_MOSI       PORTB
+  #define DDR_MOSI        DDRB
+  #define PIN_MOSI        5
+  #define PORT_MISO       PINB
+  #define PIN_MISO        6
+#endif
+
+//Data port, write strobe and read strobe of a 8080-type bus. DC is used as
+//usual, chip select may be tied low.
+#if LCD_TRANSPORT == LCD_TRANSPORT_PARALLEL
+  #define PORT_BUS        PORTC
+  #define DDR_BUS         DDRC
+  #define PIN_BUS         PINC
+  #define PORT_WR         PORTD
+  #define DDR_WR          DDRD
+  #define PIN_WR          6
+  #define PORT_RD         PORTD
+  #define DDR_RD          DDRD
+  #define PIN_RD          7
+#endif
+/*****************************************************************************
+ * END CONFIG BLOCK
+ *****************************************************************************/
+
+
+#if LCD_TRANSPORT == LCD_TRANSPORT_SPI
+/*****************************************************************************
+ * Hardware SPI: each byte has to be sent before the next one is written
+ *****************************************************************************/
+  #define LCD_BUS_INIT()  LCD_INIT_SPI()
+  #if LCD_USE_STATS && defined(spi_idle)
+    #define lcd_bus_wait()  while(!spi_idle()) LCD_STAT_INC(bus_spins)
+  #else
+    #define lcd_bus_wait()  spi_wait_for_idle()
+  #endif
+
+  static inline void lcd_bus_write(uint8_t b) {
+    lcd_bus_wait();
+    LCD_STAT_INC(bytes);
+    spi_write(b);
+    }
+
+  //The bus has to be idle before the first read. Reading SPDR clears SPIF,
+  //so lcd_bus_read_end clocks one more byte to set it again for lcd_bus_wait.
+  #ifdef spi_read
+  static inline uint8_t lcd_bus_read(void) {
+    spi_write(0);
+    lcd_bus_wait();
+    return spi_read();
+    }
+  #define lcd_bus_read_end()  spi_write(0)
+  #endif
+
+
+#elif LCD_TRANSPORT == LCD_TRANSPORT_USART_SPI
+/*****************************************************************************
+ * USART in SPI mode: the transmitter is double buffered, so the next byte
+ * can be written while the current one is sent. TXCIF is cleared on each
+ * write and set once the last byte has left.
+ *****************************************************************************/
+  #define LCD_BUS_INIT()  LCD_INIT_SPI()
+  #define lcd_bus_wait()  while(!(LCD_USART.STATUS & USART_TXCIF_bm)) LCD_STAT_INC(bus_spins)
+
+  static inline void lcd_bus_write(uint8_t b) {
+    while(!(LCD_USART.STATUS & USART_DREIF_bm))
+      LCD_STAT_INC(bus_spins);
+    LCD_STAT_INC(bytes);
+    LCD_USART.STATUS = USART_TXCIF_bm;
+    LCD_USART.DATA = b;
+    }
+
+  static inline uint8_t lcd_bus_read(void) {
+    lcd_bus_wait();
+    while(LCD_USART.STATUS & USART_RXCIF_bm)   //drop bytes received while writing
+      (void)LCD_USART.DATA;
+    lcd_bus_write(0);
+    while(!(LCD_USART.STATUS & USART_RXCIF_bm));
+    return LCD_USART.DATA;
+    }
+
+
+#elif LCD_TRANSPORT == LCD_TRANSPORT_BITBANG
+/*****************************************************************************
+ * Bit-bang SPI, mode 3 (clock idles high, data is taken on the rising edge)
+ * All transfers are finished when the functions return.
+ *****************************************************************************/
+  #define LCD_BUS_INIT()  PORT_SCK |= _BV(PIN_SCK); \
+                          DDR_SCK  |= _BV(PIN_SCK); \
+                          DDR_MOSI |= _BV(PIN_MOSI)
+  #define lcd_bus_wait()
+
+  static inline void lcd_bus_write(uint8_t b) {
+    LCD_STAT_INC(bytes);
+    for(uint8_t mask = 0x80; mask; mask >>= 1) {
+      if (b & mask) PORT_MOSI |=  _BV(PIN_MOSI);
+      else          PORT_MOSI &= ~_BV(PIN_MOSI);
+      PORT_SCK &= ~_BV(PIN_SCK);
+      PORT_SCK |=  _BV(PIN_SCK);
+      }
+    }
+
+  static inline uint8_t lcd_bus_read(void) {
+    uint8_t b = 0;
+    for(uint8_t i = 8; i; i--) {
+      PORT_SCK &= ~_BV(PIN_SCK);
+      PORT_SCK |=  _BV(PIN_SCK);
+      b = (b << 1) | ((PORT_MISO >> PIN_MISO) & 1);
+      }
+    return b;
+    }
+
+
+#elif LCD_TRANSPORT == LCD_TRANSPORT_PARALLEL
+/*****************************************************************************
+ * 8080-type parallel bus: a byte is taken on the rising edge of WR
+ *****************************************************************************/
+  #define LCD_BUS_INIT()  PORT_WR |= _BV(PIN_WR); DDR_WR |= _BV(PIN_WR); \
+                          PORT_RD |= _BV(PIN_RD); DDR_RD |= _BV(PIN_RD); \
+                          DDR_BUS = 0xFF
+  #define lcd_bus_wait()
+  #define LCD_BUS_STROBE() PORT_WR &= ~_BV(PIN_WR); PORT_WR |= _BV(PIN_WR)
+
+  static inline void lcd_bus_write(uint8_t b) {
+    LCD_STAT_INC(bytes);
+    PORT_BUS = b;
+    LCD_BUS_STROBE();
+    }
+
+  static inline uint8_t lcd_bus_read(void) {
+    uint8_t b;
+    DDR_BUS = 0;
+    PORT_RD &= ~_BV(PIN_RD);
+    _delay_us(0.4);           //read access time of the controller
+    b = PIN_BUS;
+    PORT_RD |= _BV(PIN_RD);
+    DDR_BUS = 0xFF;
+    return b;
+    }
+
+  //Equal bytes (e.g. black, white) only need write strobes
+  #define LCD_BUS_HAS_REPEAT
+  static inline void lcd_bus_write_repeat(uint8_t hi, uint8_t lo, uint32_t count) {
+    LCD_STAT_ADD(bytes, 2*count);
+    if (hi == lo) {
+      PORT_BUS = hi;
+      for(; count; count--) {
+        LCD_BUS_STROBE();
+        LCD_BUS_STROBE();
+        }
+      return;
+      }
+    for(; count; count--) {
+      PORT_BUS = hi; LCD_BUS_STROBE();
+      PORT_BUS = lo; LCD_BUS_STROBE();
+      }
+    }
+
+
+#elif LCD_TRANSPORT == LCD_TRANSPORT_HOST
+/*****************************************************************************
+ * Host program, e.g. a traffic recorder or display emulator. dc is the state
+ * of the DC (A0) pin, 1 for data. See host/lcd-host-bus.h
+ *****************************************************************************/
+  void    lcd_host_bus_write(uint8_t b, uint8_t dc);
+  uint8_t lcd_host_bus_read(void);
+  void    lcd_host_bus_select(uint8_t selected);
+  #define LCD_BUS_SELECTED(s) lcd_host_bus_select(s)
+  #define LCD_BUS_INIT()
+  #define lcd_bus_wait()
+  #define lcd_bus_write(b) (LCD_STAT_INC(bytes), lcd_host_bus_write((b), LCD_BUS_DC() ? 1 : 0))
+  #define lcd_bus_read()   lcd_host_bus_read()
+
+#else
+  #error "Unknown LCD_TRANSPORT"
+#endif
+
+//Called by LCD_SELECT / LCD_UNSELECT after changing chip select
+#ifndef LCD_BUS_SELECTED
+  #define LCD_BUS_SELECTED(s)
+#endif
+
+//Called after a sequence of lcd_bus_read
+#ifndef lcd_bus_read_end
+  #define lcd_bus_read_end()
+#endif
+
+
+/*****************************************************************************
+ * Generic versions of block transfers
+ *****************************************************************************/
+static inline void lcd_bus_write_burst(const uint8_t *p, uint16_t n) {
+  for(; n; n--)
+    lcd_bus_write(*p++);
+  }
+
+#ifndef LCD_BUS_HAS_REPEAT
+//The loop is unrolled to send four pairs per iteration
+static inline void lcd_bus_write_repeat(uint8_t hi, uint8_t lo, uint32_t count) {
+  uint8_t rest = count & 3;
+  for(count >>= 2; count; count--) {
+    lcd_bus_write(hi); lcd_bus_write(lo);
+    lcd_bus_write(hi); lcd_bus_write(lo);
+    lcd_bus_write(hi); lcd_bus_write(lo);
+    lcd_bus_write(hi); lcd_bus_write(lo);
+    }
+  for(; rest; rest--) {
+    lcd_bus_write(hi); lcd_bus_write(lo);
+    }
+  }
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef LCD_TRANSPOSE_H_INCLUDED
+#define LCD_TRANSPOSE_H_INCLUDED
+
+/******************************************************************************
+ * Transposition of 8 x 8 pixels, used by dogm-graphic (portrait orientation,
+ * row-major bitmaps) and, with both libraries, by the font generator for
+ * rotated text (LCD_TRANSPOSE in font.h). Converts 8 vertical bytes to 8
+ * horizontal ones and back: bit b of dst[k] is set to bit k of src[b].
+ *
+ * Three steps exchange 1x1, 2x2 and 4x4 sub-blocks between the bytes i and
+ * i+j, using only 8 bit operations (the shift by 4 is a nibble swap).
+ *
+ * Author:  Jan Michel (jan at mueschelsoft dot de)
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#define LCD_SWAP_BITS(a,b,j,m)  t = ((a >> j) ^ b) & m; b ^= t; a ^= t << j
+
+/******************************************************************************
+ * src           - 8 bytes
+ * dst           - 8 bytes, may be the same as src
+ */
+static inline void lcd_transpose_8x8(const uint8_t *src, uint8_t *dst) {
+  uint8_t r0 = src[0], r1 = src[1], r2 = src[2], r3 = src[3];
+  uint8_t r4 = src[4], r5 = src[5], r6 = src[6], r7 = src[7];
+  uint8_t t;
+  LCD_SWAP_BITS(r0,r1,1,0x55); LCD_SWAP_BITS(r2,r3,1,0x55);
+  LCD_SWAP_BITS(r4,r5,1,0x55); LCD_SWAP_BITS(r6,r7,1,0x55);
+  LCD_SWAP_BITS(r0,r2,2,0x33); LCD_SWAP_BITS(r1,r3,2,0x33);
+  LCD_SWAP_BITS(r4,r6,2,0x33); LCD_SWAP_BITS(r5,r7,2,0x33);
+  LCD_SWAP_BITS(r0,r4,4,0x0F); LCD_SWAP_BITS(r1,r5,4,0x0F);
+  LCD_SWAP_BITS(r2,r6,4,0x0F); LCD_SWAP_BITS(r3,r7,4,0x0F);
+  dst[0] = r0; dst[1] = r1; dst[2] = r2; dst[3] = r3;
+  dst[4] = r4; dst[5] = r5; dst[6] = r6; dst[7] = r7;
+  }
+
+#undef LCD_SWAP_BITS
+
+#endif
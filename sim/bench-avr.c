@@ -0,0 +1,313 @@
+/******************************************************************************
+ * Firmware for the cycle benchmark, runs on a simulated AVR (see simbench.c)
+ *
+ * Each measurement is marked by writes to the GPIO registers:
+ *   GPIOR1      name of the measurement, one character per write
+ *   GPIOR2      number of units (characters, bytes, pages), low then high byte
+ *   GPIOR0      SIM_MARK_START, SIM_MARK_STOP, SIM_MARK_EXIT
+ * The bus is a stub: each byte is written to SPDR without waiting, so the
+ * cycles are those of the library, not of the SPI transfer.
+ * Built with SIM_SPI_PRESCALER, the stub models an SPI master instead: a
+ * byte takes 8 x SIM_SPI_PRESCALER cycles (timer 1), the next write and
+ * the deselect wait for it. Only the spi/ workload is run then, its units
+ * are the bytes sent.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/pgmspace.h>
+#include "font.h"
+
+#define SIM_MARK_START  1
+#define SIM_MARK_STOP   2
+#define SIM_MARK_EXIT   3
+
+#define BENCH_TEXT      "Quick fox 0123456789"
+#define BENCH_TEXT_LEN  (sizeof(BENCH_TEXT)-1)
+
+
+/******************************************************************************
+ * Bus stub, replaces the host program of LCD_TRANSPORT_HOST
+ */
+#ifndef SIM_SPI_PRESCALER
+void lcd_host_bus_write(uint8_t b, uint8_t dc) {
+  (void)dc;
+  SPDR = b;
+  }
+
+void lcd_host_bus_select(uint8_t selected) {
+  (void)selected;
+  }
+
+void init_spi_lcd(void) {
+  }
+
+#else
+#define SIM_SPI_CYCLES  (8 * SIM_SPI_PRESCALER)
+
+static uint16_t sim_spi_started;    //TCNT1 at the start of the last byte
+static uint16_t sim_spi_bytes;
+
+static void sim_spi_wait(void) {
+  while ((uint16_t)(TCNT1 - sim_spi_started) < SIM_SPI_CYCLES)
+    ;
+  }
+
+void lcd_host_bus_write(uint8_t b, uint8_t dc) {
+  (void)dc;
+  sim_spi_wait();
+  sim_spi_started = TCNT1;
+  sim_spi_bytes++;
+  SPDR = b;
+  }
+
+void lcd_host_bus_select(uint8_t selected) {
+  if (!selected)
+    sim_spi_wait();
+  }
+
+void init_spi_lcd(void) {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);               //timer 1 at F_CPU
+  sim_spi_started = TCNT1 - SIM_SPI_CYCLES;
+  }
+#endif
+
+uint8_t lcd_host_bus_read(void) {
+  return SPDR;
+  }
+
+
+/******************************************************************************
+ * Measurement markers
+ */
+static void sim_name_P(PGM_P name) {
+  char c;
+  while ((c = pgm_read_byte(name++)))
+    GPIOR1 = c;
+  }
+
+static void sim_start(uint16_t units) {
+  GPIOR2 = units & 0xFF;
+  GPIOR2 = units >> 8;
+  GPIOR0 = SIM_MARK_START;
+  }
+
+static inline void sim_stop(void) {
+  GPIOR0 = SIM_MARK_STOP;
+  }
+
+
+/******************************************************************************
+ * The workload
+ */
+#ifndef SIM_SPI_PRESCALER
+static const char bench_name_fixed8[]  PROGMEM = "fixed8";
+static const char bench_name_fixed16[] PROGMEM = "fixed16";
+static const char bench_name_prop8[]   PROGMEM = "prop8";
+static const char bench_name_prop16[]  PROGMEM = "prop16";
+static const char bench_name_digit24[] PROGMEM = "digits24";
+static const char bench_name_digit32[] PROGMEM = "digits32";
+
+static const struct {FONT_P font; PGM_P name;} bench_fonts[] = {
+#ifdef FONTS_INCLUDE_font_fixed_8px
+  {FONT_FIXED_8, bench_name_fixed8},
+#endif
+#ifdef FONTS_INCLUDE_font_fixed_16px
+  {FONT_FIXED_16, bench_name_fixed16},
+#endif
+#ifdef FONTS_INCLUDE_font_proportional_8px
+  {FONT_PROP_8, bench_name_prop8},
+#endif
+#ifdef FONTS_INCLUDE_font_proportional_16px
+  {FONT_PROP_16, bench_name_prop16},
+#endif
+#ifdef FONTS_INCLUDE_digits_24px
+  {FONT_DIGITS_24, bench_name_digit24},
+#endif
+#ifdef FONTS_INCLUDE_digits_32px
+  {FONT_DIGITS_32, bench_name_digit32},
+#endif
+  };
+
+static void bench_text(void) {
+  for (uint8_t f = 0; f < sizeof(bench_fonts)/sizeof(bench_fonts[0]); f++) {
+    lcd_moveto_xy(0,0);
+    sim_name_P(PSTR("char/"));
+    sim_name_P(bench_fonts[f].name);
+    sim_start(BENCH_TEXT_LEN);
+    lcd_put_string_P(bench_fonts[f].font, NORMAL, PSTR(BENCH_TEXT));
+    sim_stop();
+    }
+#ifdef FONTS_INCLUDE_font_fixed_8px
+  lcd_moveto_xy(0,0);
+  sim_name_P(PSTR("char/fixed8/dheight"));
+  sim_start(BENCH_TEXT_LEN);
+  lcd_put_string_P(FONT_FIXED_8, DOUBLE_HEIGHT, PSTR(BENCH_TEXT));
+  sim_stop();
+
+  lcd_moveto_xy(0,0);
+  sim_name_P(PSTR("char/fixed8/dwidth"));
+  sim_start(BENCH_TEXT_LEN);
+  lcd_put_string_P(FONT_FIXED_8, DOUBLE_WIDTH, PSTR(BENCH_TEXT));
+  sim_stop();
+
+  #if INCLUDE_ROTATED_TEXT == 1 && !defined(LCD_DOUBLE_PIXEL)
+  lcd_moveto_xy(0,0);
+  sim_name_P(PSTR("char/fixed8/rotate90"));
+  sim_start(BENCH_TEXT_LEN);
+  lcd_put_string_P(FONT_FIXED_8, ROTATE_90, PSTR(BENCH_TEXT));
+  sim_stop();
+  #endif
+#endif
+  }
+
+static void bench_cursor(void) {
+  sim_name_P(PSTR("cursor/moveto_xy"));
+  sim_start(64);
+  for (uint8_t i = 0; i < 64; i++)
+    lcd_moveto_xy(i & 3, i);
+  sim_stop();
+  }
+
+#ifndef LCD_COLOR_GRAPHIC
+//2 pages x 32 columns
+static const uint8_t bench_image[64] PROGMEM = {
+  0x00, 0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x00, 0x3C, 0x42, 0x81, 0x81, 0x42, 0x3C,
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0xAA, 0x55, 0xAA, 0x55, 0x00, 0x00, 0xF0, 0x0F,
+  0xFF, 0x00, 0xFF, 0x00, 0x18, 0x24, 0x42, 0x81, 0x81, 0x42, 0x24, 0x18, 0x00, 0x00, 0x00, 0x00,
+  0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, 0x55, 0xAA, 0x55, 0xAA, 0xFF, 0xFF, 0x0F, 0xF0,
+  };
+
+static void bench_graphics(void) {
+  lcd_moveto_xy(1,8);
+  sim_name_P(PSTR("image_byte/draw_P"));
+  sim_start(sizeof(bench_image));
+  lcd_draw_image_P(bench_image, 2, 32, NORMAL);
+  sim_stop();
+
+  sim_name_P(PSTR("image_byte/draw_xy_P"));
+  sim_start(sizeof(bench_image));
+  lcd_draw_image_xy_P(bench_image, 40, 12, 2, 32, NORMAL);
+  sim_stop();
+
+#if LCD_INCLUDE_BITMAP_FUNCTIONS == 1
+  //Same bytes as row-major bitmap of 32 x 16 pixels in RAM
+  static uint8_t bitmap[sizeof(bench_image)];
+  memcpy_P(bitmap, bench_image, sizeof(bitmap));
+  lcd_moveto_xy(1,8);
+  sim_name_P(PSTR("image_byte/draw_bitmap"));
+  sim_start(sizeof(bitmap));
+  lcd_draw_bitmap(bitmap, 32, 16, LCD_BITMAP_MSB_FIRST);
+  sim_stop();
+#endif
+
+  lcd_moveto_xy(0,0);
+  sim_name_P(PSTR("page/clear_area"));
+  sim_start(LCD_RAM_PAGES);
+  lcd_clear_area(LCD_RAM_PAGES, LCD_WIDTH, NORMAL);
+  sim_stop();
+
+  static uint8_t block[8] = {0x00, 0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81};
+  sim_name_P(PSTR("block/transpose_8x8"));
+  sim_start(64);
+  for (uint8_t i = 0; i < 64; i++)
+    lcd_transpose_8x8(block, block);
+  sim_stop();
+
+#if LCD_ROTATION == 90 || LCD_ROTATION == 270
+  //Whole frame in portrait orientation, per 8 x 8 block
+  static uint8_t view[LCD_VIEW_PAGES * LCD_VIEW_WIDTH];
+  lcd_canvas_t canvas;
+  lcd_canvas_init(&canvas, view, LCD_VIEW_WIDTH, LCD_VIEW_PAGES);
+  sim_name_P(PSTR("block/flush_rotated"));
+  sim_start(LCD_VIEW_PAGES * LCD_VIEW_WIDTH / 8);
+  lcd_canvas_flush_rotated(&canvas, 0);
+  sim_stop();
+  sim_name_P(PSTR("frame/flush_rotated"));
+  sim_start(1);
+  lcd_canvas_flush_rotated(&canvas, 0);
+  sim_stop();
+#endif
+  }
+
+#else
+static void bench_graphics(void) {
+  color_t c = {10, 20, 30};
+  sim_name_P(PSTR("pixel/fill_rect"));
+  sim_start(100*100);
+  lcd_fill_rect(0, 0, 100, 100, c);
+  sim_stop();
+  }
+#endif
+#endif
+
+
+#ifdef SIM_SPI_PRESCALER
+/******************************************************************************
+ * Bus throughput at one SPI clock, the bytes of each part are counted in
+ * a first run
+ */
+#define SIM_STRING(x)   #x
+#define SIM_PRESCALER_NAME(p)  "spi/clk" SIM_STRING(p)
+
+static void bench_spi_part(uint8_t part) {
+  switch (part) {
+  #ifdef FONTS_INCLUDE_font_fixed_8px
+    case 0:
+      lcd_moveto_xy(0,0);
+      lcd_put_string_P(FONT_FIXED_8, NORMAL, PSTR(BENCH_TEXT));
+      break;
+  #endif
+  #ifndef LCD_COLOR_GRAPHIC
+    case 1:
+      lcd_moveto_xy(0,0);
+      lcd_clear_area(LCD_RAM_PAGES, LCD_WIDTH, NORMAL);
+      break;
+  #else
+    case 1: {
+      color_t c = {10, 20, 30};
+      lcd_fill_rect(0, 0, 100, 100, c);
+      break;
+      }
+  #endif
+    }
+  }
+
+static void bench_spi(void) {
+  static const char names[2][8] PROGMEM = {"/text", "/fill"};
+  for (uint8_t part = 0; part < 2; part++) {
+    sim_spi_bytes = 0;
+    bench_spi_part(part);
+    uint16_t bytes = sim_spi_bytes;
+    sim_name_P(PSTR(SIM_PRESCALER_NAME(SIM_SPI_PRESCALER)));
+    sim_name_P(names[part]);
+    sim_start(bytes);
+    bench_spi_part(part);
+    sim_stop();
+    }
+  }
+#endif
+
+
+int main(void) {
+  lcd_init();
+  //Calibration: cycles of the markers alone, subtracted by simbench
+  sim_name_P(PSTR("empty"));
+  sim_start(1);
+  sim_stop();
+#ifdef SIM_SPI_PRESCALER
+  bench_spi();
+#else
+  bench_text();
+  bench_cursor();
+  bench_graphics();
+#endif
+  GPIOR0 = SIM_MARK_EXIT;
+  cli();
+  sleep_mode();
+  return 0;
+  }
@@ -0,0 +1,15 @@
+/******************************************************************************
+ * Included before all sources of the firmware (-include sim-io.h).
+ * Maps the ports of the library configuration that the simulated
+ * controller does not have.
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <avr/io.h>
+
+//XMEGA port F of the dogm-graphic configuration
+#ifndef PORTF_OUT
+  #define PORTF_OUT  PORTC
+  #define PORTF_DIR  DDRC
+#endif
@@ -0,0 +1,114 @@
+/******************************************************************************
+ * Runs bench-avr firmware on simavr and prints the cycles of each marked
+ * measurement per unit and the units per second at the given frequency.
+ * See bench-avr.c for the markers.
+ *
+ * Usage: simbench mcu frequency firmware.elf
+ *
+ * License: GNU General Public License, version 3
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+
+//Data addresses of GPIOR0..2, ATmega164/324/644/1284
+#define SIM_GPIOR0  0x3E
+#define SIM_GPIOR1  0x4A
+#define SIM_GPIOR2  0x4B
+
+#define SIM_MARK_START  1
+#define SIM_MARK_STOP   2
+#define SIM_MARK_EXIT   3
+
+static char     sim_name[64];
+static uint8_t  sim_name_length;
+static uint16_t sim_units;
+static uint8_t  sim_units_bytes;
+static avr_cycle_count_t sim_started, sim_overhead;
+static double   sim_frequency;
+static int      sim_exit;
+
+
+static void sim_write_name(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  if (sim_name_length < sizeof(sim_name) - 1)
+    sim_name[sim_name_length++] = v;
+  sim_name[sim_name_length] = 0;
+  }
+
+static void sim_write_units(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  if (sim_units_bytes++ & 1)
+    sim_units |= (uint16_t)v << 8;
+  else
+    sim_units = v;
+  }
+
+static void sim_write_mark(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  avr_cycle_count_t cycles;
+  switch (v) {
+    case SIM_MARK_START:
+      sim_started = avr->cycle;
+      break;
+    case SIM_MARK_STOP:
+      cycles = avr->cycle - sim_started;
+      if (!strcmp(sim_name, "empty")) {
+        sim_overhead = cycles;
+        }
+      else {
+        cycles -= sim_overhead;
+        printf("%-28s %10llu %6u %10.1f %12.0f\n", sim_name, (unsigned long long)cycles,
+               sim_units, sim_units ? (double)cycles / sim_units : 0.0,
+               cycles ? sim_units * sim_frequency / cycles : 0.0);
+        }
+      sim_name_length = 0;
+      sim_name[0]     = 0;
+      sim_units_bytes = 0;
+      break;
+    case SIM_MARK_EXIT:
+      sim_exit = 1;
+      break;
+    }
+  }
+
+
+int main(int argc, char **argv) {
+  elf_firmware_t fw;
+  avr_t *avr;
+  int state;
+
+  if (argc != 4) {
+    fprintf(stderr, "usage: %s mcu frequency firmware.elf\n", argv[0]);
+    return 2;
+    }
+  memset(&fw, 0, sizeof(fw));
+  if (elf_read_firmware(argv[3], &fw)) {
+    fprintf(stderr, "cannot read %s\n", argv[3]);
+    return 1;
+    }
+  snprintf(fw.mmcu, sizeof(fw.mmcu), "%s", argv[1]);
+  fw.frequency = strtoul(argv[2], NULL, 0);
+  sim_frequency = fw.frequency;
+
+  avr = avr_make_mcu_by_name(fw.mmcu);
+  if (!avr) {
+    fprintf(stderr, "unknown mcu %s\n", fw.mmcu);
+    return 1;
+    }
+  avr_init(avr);
+  avr_load_firmware(avr, &fw);
+  avr_register_io_write(avr, SIM_GPIOR0, sim_write_mark,  NULL);
+  avr_register_io_write(avr, SIM_GPIOR1, sim_write_name,  NULL);
+  avr_register_io_write(avr, SIM_GPIOR2, sim_write_units, NULL);
+
+  printf("%-28s %10s %6s %10s %12s\n", "measurement", "cycles", "units", "per unit", "per second");
+  do {
+    state = avr_run(avr);
+    } while (!sim_exit && state != cpu_Done && state != cpu_Crashed);
+  if (!sim_exit) {
+    fprintf(stderr, "firmware stopped before the end of the workload\n");
+    return 1;
+    }
+  return 0;
+  }
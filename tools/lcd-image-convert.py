@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""
+Image converter for lcdlib
+
+Converts a monochrome PBM image (P1 or P4) into a C array for
+lcd_draw_image_packed_P(). The image is stored in page-major order as used
+by the EA-DOG displays, the encoding (raw or packbits) is chosen per image,
+whichever is smaller.
+
+Color PPM images (P3 or P6) are converted for lcd_draw_image_xy_P() of
+lcd-color-graphic. The encoding (raw, rle or palette) is chosen the same way.
+
+Usage: lcd-image-convert.py [-n name] [-f auto|raw|packbits|rle|palette] image
+"""
+
+import argparse
+import os
+import sys
+
+LCD_IMAGE_RAW = 0
+LCD_IMAGE_PACKBITS = 1
+LCD_IMAGE_RLE = 2
+LCD_IMAGE_PALETTE = 3
+
+
+def read_image(filename):
+    """Returns color flag, width, height and a list of rows. Each row is a
+    list of 0/1 pixels for PBM and a list of (r, g, b) tuples for PPM"""
+    with open(filename, 'rb') as f:
+        data = f.read()
+    tokens = []
+    pos = 0
+
+    def next_token():
+        nonlocal pos
+        while True:
+            while pos < len(data) and data[pos:pos+1].isspace():
+                pos += 1
+            if data[pos:pos+1] == b'#':
+                while pos < len(data) and data[pos:pos+1] not in (b'\n', b'\r'):
+                    pos += 1
+            else:
+                break
+        start = pos
+        while pos < len(data) and not data[pos:pos+1].isspace():
+            pos += 1
+        return data[start:pos]
+
+    magic = next_token()
+    width = int(next_token())
+    height = int(next_token())
+    rows = []
+    if magic in (b'P3', b'P6'):
+        maxval = int(next_token())
+        if magic == b'P3':
+            values = [int(v) for v in data[pos:].split()]
+        else:
+            pos += 1
+            size = 2 if maxval > 255 else 1
+            values = [int.from_bytes(data[i:i+size], 'big')
+                      for i in range(pos, pos + width*height*3*size, size)]
+        values = [v * 255 // maxval for v in values]
+        for y in range(height):
+            line = values[y*width*3:(y+1)*width*3]
+            rows.append([tuple(line[x*3:x*3+3]) for x in range(width)])
+        return True, width, height, rows
+    if magic == b'P1':
+        bits = [c - 48 for c in data[pos:] if c in (48, 49)]
+        for y in range(height):
+            rows.append(bits[y*width:(y+1)*width])
+    elif magic == b'P4':
+        pos += 1
+        stride = (width + 7) // 8
+        for y in range(height):
+            line = data[pos + y*stride:pos + (y+1)*stride]
+            rows.append([(line[x >> 3] >> (7 - (x & 7))) & 1 for x in range(width)])
+    else:
+        raise ValueError("%s: not a PBM or PPM image" % filename)
+    return False, width, height, rows
+
+
+def to_pages(width, height, rows):
+    """Converts rows of pixels into page-major vertical bytes"""
+    pages = (height + 7) // 8
+    out = []
+    for page in range(pages):
+        for x in range(width):
+            b = 0
+            for bit in range(8):
+                y = page*8 + bit
+                if y < height and rows[y][x]:
+                    b |= 1 << bit
+            out.append(b)
+    return pages, out
+
+
+def packbits(data):
+    """Encodes data using the token format described in dogm-graphic.h"""
+    out = []
+    literal = []
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 130:
+            run += 1
+        if run >= 3:
+            if literal:
+                out += [len(literal) - 1] + literal
+                literal = []
+            out += [0x80 + run - 3, data[i]]
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+            if len(literal) == 128:
+                out += [len(literal) - 1] + literal
+                literal = []
+    if literal:
+        out += [len(literal) - 1] + literal
+    return out
+
+
+def encode(data, fmt):
+    """Returns the encoded image including the encoding byte"""
+    candidates = {
+        'raw':      [LCD_IMAGE_RAW] + data,
+        'packbits': [LCD_IMAGE_PACKBITS] + packbits(data),
+        }
+    return choose(candidates, fmt)
+
+
+def choose(candidates, fmt):
+    """Selects the requested or the smallest encoding"""
+    if fmt == 'auto':
+        return min(candidates.items(), key=lambda c: len(c[1]))
+    if fmt not in candidates:
+        raise ValueError("format %s not available for this image" % fmt)
+    return fmt, candidates[fmt]
+
+
+def rgb565(pixel):
+    r, g, b = pixel
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def color_tokens(pixels, size):
+    """Encodes a list of pixels using the token format described in
+    lcd-color-graphic.h. size(pixel) returns the encoded bytes of a pixel"""
+    out = []
+    literal = []
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and pixels[i + run] == pixels[i] and run < 129:
+            run += 1
+        # a run of two only pays off if a pixel needs more than one byte
+        if run >= 3 or (run == 2 and len(size(pixels[i])) > 1):
+            if literal:
+                out += [len(literal) - 1] + [b for p in literal for b in size(p)]
+                literal = []
+            out += [0x80 + run - 2] + size(pixels[i])
+            i += run
+        else:
+            literal.append(pixels[i])
+            i += 1
+            if len(literal) == 128:
+                out += [len(literal) - 1] + [b for p in literal for b in size(p)]
+                literal = []
+    if literal:
+        out += [len(literal) - 1] + [b for p in literal for b in size(p)]
+    return out
+
+
+def encode_color(width, height, rows, fmt):
+    """Returns the encoded color image including the header"""
+    pixels = [rgb565(p) for row in rows for p in row]
+    word = lambda c: [c >> 8, c & 0xFF]
+    header = [width & 0xFF, width >> 8, height & 0xFF, height >> 8]
+    candidates = {
+        'raw': [LCD_IMAGE_RAW] + header + [b for c in pixels for b in word(c)],
+        'rle': [LCD_IMAGE_RLE] + header + color_tokens(pixels, word),
+        }
+    colors = sorted(set(pixels))
+    if len(colors) <= 256:
+        index = {c: i for i, c in enumerate(colors)}
+        palette = [b for c in colors for b in word(c)]
+        candidates['palette'] = ([LCD_IMAGE_PALETTE] + header + [len(colors) & 0xFF] +
+                                 palette + color_tokens([index[c] for c in pixels],
+                                                        lambda i: [i]))
+    return choose(candidates, fmt)
+
+
+def write_array(name, comment, data, out):
+    out.write("//created with lcd-image-convert.py\n")
+    out.write("//%s\n" % comment)
+    out.write("const uint8_t %s[] PROGMEM = {\n" % name)
+    for i in range(0, len(data), 16):
+        out.write("    " + ", ".join("0x%02X" % b for b in data[i:i+16]) + ",\n")
+    out.write("    };\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert images for lcdlib")
+    parser.add_argument('image')
+    parser.add_argument('-n', '--name', help="name of the C array")
+    parser.add_argument('-f', '--format', default='auto',
+                        choices=['auto', 'raw', 'packbits', 'rle', 'palette'])
+    args = parser.parse_args()
+
+    name = args.name or os.path.splitext(os.path.basename(args.image))[0].replace('-', '_')
+    color, width, height, rows = read_image(args.image)
+    if color:
+        fmt, encoded = encode_color(width, height, rows, args.format)
+        comment = "%d x %d pixels, %s, %d bytes (raw %d)" % (
+            width, height, fmt, len(encoded), 2*width*height + 5)
+    else:
+        pages, data = to_pages(width, height, rows)
+        fmt, encoded = encode(data, args.format)
+        comment = "%d x %d pixels, %d pages, %s, %d bytes (raw %d)" % (
+            width, height, pages, fmt, len(encoded), len(data))
+    write_array(name, comment, encoded, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()